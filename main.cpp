@@ -15,6 +15,29 @@ using namespace std;
 #include <unordered_map>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <map>
+#include <deque>
+#include <cmath>
+#include <cerrno>
+#if defined(__x86_64__) && !defined(_MSC_VER)
+#include <x86intrin.h>
+#elif defined(_M_X64)
+#include <intrin.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
 
 // default configuration settings, loaded from config.txt
 struct Config {
@@ -25,19 +48,24 @@ struct Config {
     long min_ins = 1000;
     long max_ins = 2000;
     long delay_per_exec = 0;
+    bool pin_cores = false;       // pin each CPU core thread to its own host CPU (Linux only)
+    int pin_first_cpu = 0;        // host CPU of core 0 when pinning; set per sweep worker, not read from config.txt
+    bool soft_affinity = false;   // requeue processes on the core they last ran on
+    int affinity_slack = 2;       // how many more queued processes than the shortest core queue counts as overloaded
+    bool optimize_programs = false; // fold constants and precompute pure arithmetic FOR loops at process creation
+    int tick_ms = 100;            // wall-clock length of one CPU tick
+    std::string metrics_socket;   // Unix socket path of the metrics/control server (Linux only), empty to disable
+    bool adaptive_quantum = false; // rr only: retune the quantum per process class to hit target_overhead
+    int quantum_min = 1;           // bounds of the adaptive quantum, in cycles
+    int quantum_max = 100;
+    double target_overhead = 5.0;  // wanted share of core time spent switching, in percent
+    int dashboard_fps = 4;         // frame rate of the "top" view
 };
 
-// global configuration
-Config g_config;
-
-std::atomic<int> g_cpu_cycles{0};
-std::queue<int> g_ready_queue;
-std::mutex g_ready_queue_mtx;
 std::mutex g_rng_mtx;
 std::atomic<int> g_attached_pid{-1};
 
 // shared state
-bool is_initialized = false;
 size_t display_width = 100;         //TO-DO : do we need this
 std::queue<char> key_buffer;    //TO-DO : do we need this
 std::mutex key_buffer_mutex;    //TO-DO : do we need this
@@ -63,10 +91,13 @@ void clear_screen() {
 
 enum class InstrType { PRINT, DECLARE, ADD, SUBTRACT, SLEEP, FOR_ };
 
+struct LoopSummary;
+
 struct Instruction {
     InstrType type{};
     // For PRINT
     std::string msg;
+    std::string print_var; // optional variable appended to msg
 
     // For DECLARE
     std::string var;
@@ -84,8 +115,13 @@ struct Instruction {
     // For FOR
     std::vector<Instruction> body;
     uint32_t repeats{0};
+    std::shared_ptr<const LoopSummary> summary; // set by the optimizer when the body is pure arithmetic
 };
 
+// Programs are immutable once built so processes spawned from the same source can share one copy
+using Program = std::vector<Instruction>;
+using ProgramPtr = std::shared_ptr<const Program>;
+
 struct PseudoProcess {
     int pid{0};
     std::string name;
@@ -94,25 +130,55 @@ struct PseudoProcess {
     bool finished{false};
     size_t pc{0};
     uint8_t sleep_left{0};
-    std::vector<Instruction> program;
+    uint8_t sleep_score{0};       // recent quanta ended by SLEEP (saturates at 3); 2+ makes it a sleeper for the adaptive quantum
+    ProgramPtr program;
     std::unordered_map<std::string, uint16_t> mem;
 
     std::vector<std::string> log; // For PRINT instruction
 
     // Stack for FOR loops
     struct LoopFrame {
-        size_t for_instr_pc; // The index (in p.program) of the FOR_ instruction
-        size_t body_pc;      // The current index within the FOR_ body
+        const Instruction* for_instr; // The FOR_ instruction (top level or nested in another body)
+        size_t body_pc;               // The current index within the FOR_ body
         uint32_t repeats_left;
     };
     std::vector<LoopFrame> loop_stack;
+
+    // Scheduling statistics (written by whoever holds the emulator's processes_mtx)
+    int arrival_tick{0};
+    bool dispatched{false};
+    int last_core{-1};
+    std::chrono::steady_clock::time_point ready_since;     // last time it entered the ready queue
+    std::chrono::steady_clock::time_point first_dispatch;
+    std::chrono::steady_clock::time_point finish_time;
+    std::chrono::steady_clock::duration wait_time{0};      // total time spent in the ready queue
 };
 
-std::vector<PseudoProcess> g_processes;
-std::mutex g_processes_mtx;
-int g_next_pid = 1;
-std::atomic<bool> scheduler_generating{false};
-std::thread scheduler;
+// Pin the calling thread to the n-th host CPU it is allowed to run on
+static bool pin_current_thread(int n) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+    int count = CPU_COUNT(&allowed);
+    if (count <= 0) return false;
+
+    int target = n % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- == 0) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            return sched_setaffinity(0, sizeof(one), &one) == 0;
+        }
+    }
+    return false;
+#else
+    (void)n;
+    return false;
+#endif
+}
 
 static inline uint16_t clamp_u16(int32_t x) {
     if (x < 0) return 0;
@@ -137,8 +203,8 @@ static long long uptime_ms(const PseudoProcess& pr) {
         std::chrono::steady_clock::now() - pr.start_time).count();
 }
 
-static std::vector<Instruction> make_default_program(const std::string& pname) {
-    std::vector<Instruction> prog;
+static Program make_default_program(const std::string& pname) {
+    Program prog;
 
     Instruction d; d.type = InstrType::DECLARE; d.var = "x"; d.value = 0; prog.push_back(d);
 
@@ -159,175 +225,432 @@ static std::vector<Instruction> make_default_program(const std::string& pname) {
     return prog;
 }
 
+// Program optimizer
+// Every ADD/SUBTRACT of a variable with itself and a literal, and every constant assignment,
+// has the form v -> clamp(v + d, lo, hi) over uint16 values. That form is closed under
+// composition, so a loop body made only of such instructions (and nested loops of them)
+// reduces to one ClampShift per variable, and k iterations of it take O(log k) to apply.
+struct ClampShift {
+    int64_t d{0};
+    int64_t lo{0};
+    int64_t hi{0xFFFF};
+
+    static int64_t clamp(int64_t x, int64_t lo, int64_t hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+    uint16_t apply(uint16_t v) const { return (uint16_t)clamp((int64_t)v + d, lo, hi); }
+
+    // keep d small: a shift that pushes every uint16 past a bound is a constant
+    void normalize() {
+        lo = clamp(lo, 0, 0xFFFF);
+        hi = clamp(hi, lo, 0xFFFF);
+        if (d >= hi) { lo = hi; d = 0; }
+        else if (d + 0xFFFF <= lo) { hi = lo; d = 0; }
+    }
 
-//intialize TO-DO: create this (already done in the command_interpreter_thread)
+    // this function applied after 'first'
+    ClampShift after(const ClampShift& first) const {
+        ClampShift r;
+        r.d = first.d + d;
+        r.lo = clamp(first.lo + d, lo, hi);
+        r.hi = clamp(first.hi + d, lo, hi);
+        r.normalize();
+        return r;
+    }
 
-//screen marquee logic TO-DO: create this
+    ClampShift power(uint64_t k) const {
+        ClampShift result, base = *this;
+        while (k > 0) {
+            if (k & 1) result = base.after(result);
+            base = base.after(base);
+            k >>= 1;
+        }
+        return result;
+    }
 
-// Scheduler Start
-void scheduler_start() {
-    scheduler_generating = true;
-    long freq = g_config.batch_process_freq;
-    if (freq <= 0) freq = 1;
+    static ClampShift constant(uint16_t v) {
+        ClampShift c;
+        c.lo = c.hi = v;
+        c.d = 0;
+        return c;
+    }
+};
 
-    long long last_tick = g_cpu_cycles.load();
+// Closed form of one FOR repeat: the effect on each variable it touches, and the number of
+// quantum cycles the same repeat costs when stepped instruction by instruction
+struct LoopSummary {
+    std::vector<std::pair<std::string, ClampShift>> effect;
+    uint64_t cycles_per_repeat{0};
+};
 
-    while (scheduler_generating && is_running) {
-        long long cur = g_cpu_cycles.load();
-        if (cur - last_tick >= freq) {
+static ClampShift& effect_of(std::vector<std::pair<std::string, ClampShift>>& effect, const std::string& var) {
+    for (auto& e : effect) {
+        if (e.first == var) return e.second;
+    }
+    effect.push_back({var, ClampShift()});
+    return effect.back().second;
+}
 
-            int running_count = 0;
-            int ready_count = 0;
+// Largest cycle count a summary may describe. Far beyond any quantum, and small enough that the
+// cycle arithmetic below cannot overflow; loops past it are simply stepped normally.
+static constexpr uint64_t kMaxSummaryCycles = (uint64_t)1 << 40;
 
-            // count running and ready processes
-            {
-                std::lock_guard<std::mutex> lk1(g_processes_mtx);
-                for (auto& p : g_processes) {
-                    if (p.running && !p.finished) running_count++;
-                }
-            }
-            {
-                std::lock_guard<std::mutex> lk2(g_ready_queue_mtx);
-                ready_count = (int)g_ready_queue.size();
+// Fold the effect of one instruction into 'effect'; false if it is not pure arithmetic
+static bool summarize_instruction(const Instruction& ins, std::vector<std::pair<std::string, ClampShift>>& effect,
+                                  uint64_t& cycles) {
+    ClampShift step;
+    const std::string* target = nullptr;
+
+    switch (ins.type) {
+        case InstrType::DECLARE:
+            target = &ins.var;
+            step = ClampShift::constant(ins.value);
+            break;
+
+        case InstrType::ADD:
+        case InstrType::SUBTRACT: {
+            target = &ins.var1;
+            bool self2 = !ins.var2_is_literal && ins.var2 == ins.var1;
+            bool self3 = !ins.var3_is_literal && ins.var3 == ins.var1;
+            bool is_add = ins.type == InstrType::ADD;
+
+            if (ins.var2_is_literal && ins.var3_is_literal) {
+                step = ClampShift::constant(clamp_u16(is_add ? ins.lit2 + ins.lit3 : ins.lit2 - ins.lit3));
+            } else if (self2 && ins.var3_is_literal) {
+                step.d = is_add ? ins.lit3 : -(int64_t)ins.lit3;
+            } else if (is_add && ins.var2_is_literal && self3) {
+                step.d = ins.lit2;
+            } else {
+                return false; // reads another variable, or v = c - v / v + v
             }
+            step.normalize();
+            break;
+        }
 
-            int active_total = running_count + ready_count;
+        case InstrType::FOR_: {
+            cycles += 1; // pushing the loop frame
+            if (ins.repeats == 0 || ins.body.empty()) return true;
 
-            // Only generate if fewer than num_cpu active processes
-            if (active_total < g_config.num_cpu) {
-                int to_generate = g_config.num_cpu - active_total;
-                for (int i = 0; i < to_generate; ++i) {
-                    PseudoProcess proc;
-                    {
-                        std::lock_guard<std::mutex> lk(g_processes_mtx);
-                        proc.pid = g_next_pid++;
-                    }
+            std::vector<std::pair<std::string, ClampShift>> inner;
+            uint64_t inner_cycles = 0;
+            for (const auto& b : ins.body) {
+                if (!summarize_instruction(b, inner, inner_cycles)) return false;
+            }
+            if (inner_cycles + 1 > kMaxSummaryCycles / ins.repeats) return false;
+            cycles += (inner_cycles + 1) * ins.repeats;
+            if (cycles > kMaxSummaryCycles) return false;
+            for (const auto& e : inner) {
+                ClampShift& cur = effect_of(effect, e.first);
+                cur = e.second.power(ins.repeats).after(cur);
+            }
+            return true;
+        }
 
-                    std::ostringstream pname_ss;
-                    pname_ss << "p";
-                    if (proc.pid < 10) pname_ss << "0";
-                    pname_ss << proc.pid;
-                    proc.name = pname_ss.str();
-                    proc.start_time = std::chrono::steady_clock::now();
-                    proc.running = false;
-                    proc.program = make_default_program(proc.name);
-
-                    {
-                        std::lock_guard<std::mutex> lk(g_processes_mtx);
-                        g_processes.push_back(std::move(proc));
-                    }
+        default:
+            return false;
+    }
 
-                    {
-                        std::lock_guard<std::mutex> lk(g_ready_queue_mtx);
-                        g_ready_queue.push(g_next_pid - 1);
-                    }
+    ClampShift& cur = effect_of(effect, *target);
+    cur = step.after(cur);
+    cycles += 1;
+    return true;
+}
 
-                    // std::cout << "[scheduler] generated " << proc.name << "\n";
-                }
+// Fold literal-only ADD/SUBTRACT into DECLARE and attach summaries to pure arithmetic loops
+static void optimize_program(Program& prog) {
+    for (auto& ins : prog) {
+        if ((ins.type == InstrType::ADD || ins.type == InstrType::SUBTRACT) &&
+            ins.var2_is_literal && ins.var3_is_literal) {
+            int32_t v = ins.type == InstrType::ADD ? ins.lit2 + ins.lit3 : ins.lit2 - ins.lit3;
+            ins.type = InstrType::DECLARE;
+            ins.var = ins.var1;
+            ins.value = clamp_u16(v);
+        } else if (ins.type == InstrType::FOR_) {
+            optimize_program(ins.body);
+            if (ins.repeats == 0 || ins.body.empty()) continue;
+
+            auto summary = std::make_shared<LoopSummary>();
+            uint64_t cycles = 0;
+            bool pure = true;
+            for (const auto& b : ins.body) {
+                if (!summarize_instruction(b, summary->effect, cycles)) { pure = false; break; }
+            }
+            if (pure) {
+                summary->cycles_per_repeat = cycles + 1; // + the end-of-body check
+                ins.summary = summary;
             }
-
-            last_tick = cur;
         }
+    }
+}
 
-        // give CPU threads time to pick up work
-        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+// Apply 'k' repeats of a summarized loop to the process memory
+static void apply_loop_summary(PseudoProcess& p, const LoopSummary& sum, uint64_t k) {
+    for (const auto& e : sum.effect) {
+        uint16_t& v = p.mem[e.first]; // auto-declares to 0 like read_val
+        v = e.second.power(k).apply(v);
     }
+}
 
-    scheduler_generating = false;
+// Wrap a freshly built program, running the optimizer pass when enabled
+static ProgramPtr finalize_program(Program prog, bool optimize) {
+    if (optimize) optimize_program(prog);
+    return std::make_shared<const Program>(std::move(prog));
 }
 
-// Scheduler Stop
-void scheduler_stop() {
-    // Signal the generator to stop
-    scheduler_generating = false;
+// Program file parser (single pass over the file buffer, no token list)
+// Instructions may be separated by newlines, ';' or ',':
+//   DECLARE(var, value)
+//   ADD(var1, var2/value, var3/value)
+//   SUBTRACT(var1, var2/value, var3/value)
+//   PRINT("message") or PRINT("message" + var)
+//   SLEEP(ticks)                  (SLEEP(0) yields the core)
+//   FOR([instructions], repeats)   (nested up to 3 levels)
+// '#' starts a comment that runs to the end of the line.
+struct ProgramParser {
+    static constexpr int kMaxForDepth = 3;
+
+    const char* cur;
+    const char* end;
+    int line{1};
+    std::string error;
+
+    ProgramParser(const char* data, size_t size) : cur(data), end(data + size) {}
+
+    bool fail(const std::string& what) {
+        if (error.empty()) error = "line " + std::to_string(line) + ": " + what;
+        return false;
+    }
 
-    // If thread is joinable (we created a non-detached thread), join it to clean up
-    if (scheduler.joinable()) {
-        try {
-            scheduler.join();
-        } catch (...) {
-            // swallow exceptions to avoid termination; nothing much to do here
+    void skip_space() {
+        while (cur < end) {
+            if (*cur == '\n') { line++; cur++; }
+            else if (*cur == ' ' || *cur == '\t' || *cur == '\r') cur++;
+            else if (*cur == '#') { while (cur < end && *cur != '\n') cur++; }
+            else break;
         }
     }
-}
 
-// Report Utilization
-// If out_file is non-empty, the same report is also saved to that file (overwrites existing file).
-void report_utilization(const std::string& out_file = "") {
-    std::lock_guard<std::mutex> lk(g_processes_mtx);
-    std::ostringstream oss;
+    bool expect(char c) {
+        skip_space();
+        if (cur >= end || *cur != c) return fail(std::string("expected '") + c + "'");
+        cur++;
+        return true;
+    }
 
-    int cores_used = 0;
-    for (const auto& p : g_processes) {
-        // 'running' == true means it's on a core OR sleeping
-        if (p.running) { 
-            cores_used++;
+    // identifier: [A-Za-z_][A-Za-z0-9_]*, returned as a range into the buffer
+    bool ident(const char*& b, size_t& n) {
+        skip_space();
+        b = cur;
+        if (cur < end && (isalpha((unsigned char)*cur) || *cur == '_')) {
+            while (cur < end && (isalnum((unsigned char)*cur) || *cur == '_')) cur++;
         }
+        n = (size_t)(cur - b);
+        return n > 0 ? true : fail("expected a name");
     }
-    int cores_available = g_config.num_cpu - cores_used;
-    if (cores_available < 0) cores_available = 0; // Safety check
-    
-    double cpu_utilization = 0.0;
-    if (g_config.num_cpu > 0) {
-        cpu_utilization = (static_cast<double>(cores_used) / g_config.num_cpu) * 100.0;
+
+    // unsigned literal, saturating instead of overflowing
+    bool number(uint32_t& v) {
+        skip_space();
+        if (cur >= end || !isdigit((unsigned char)*cur)) return fail("expected a number");
+        uint64_t acc = 0;
+        while (cur < end && isdigit((unsigned char)*cur)) {
+            acc = acc * 10 + (uint64_t)(*cur - '0');
+            if (acc > 0xFFFFFFFFull) acc = 0xFFFFFFFFull;
+            cur++;
+        }
+        v = (uint32_t)acc;
+        return true;
     }
 
-    oss << "CPU utilization: " << (int)cpu_utilization << "%\n";
-    oss << "Cores used: " << cores_used << "\n";
-    oss << "Cores available: " << cores_available << "\n\n";
-    
-    if (g_processes.empty()) {
-        oss << "No processes found.\n";
-    } else {
-        oss << "PID\tSTATE\tUPTIME(ms)\tNAME\n";
-        for (const auto& p : g_processes) {
-            const char* st = p.finished ? "FINISHED" : (p.running ? "RUNNING" : "READY");
-            oss << p.pid << '\t' << st << '\t' << uptime_ms(p) << '\t' << p.name << '\n';
+    // var or literal, as used by ADD/SUBTRACT
+    bool operand(std::string& var, bool& is_lit, uint16_t& lit) {
+        skip_space();
+        if (cur < end && isdigit((unsigned char)*cur)) {
+            uint32_t v;
+            if (!number(v)) return false;
+            is_lit = true;
+            lit = v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+            return true;
         }
+        const char* b; size_t n;
+        if (!ident(b, n)) return false;
+        is_lit = false;
+        var.assign(b, n);
+        return true;
     }
 
-    // Print to console
-    std::cout << oss.str();
+    static bool word_is(const char* b, size_t n, const char* kw) {
+        return n == strlen(kw) && memcmp(b, kw, n) == 0;
+    }
 
-    // Optionally save to file (overwrite)
-    if (!out_file.empty()) {
-        std::ofstream ofs(out_file, std::ios::out | std::ios::trunc);
-        if (ofs.is_open()) {
-            ofs << oss.str();
-            ofs.close();
-            std::cout << "Saved report to '" << out_file << "'.\n";
+    bool parse_print(Instruction& ins) {
+        skip_space();
+        if (cur < end && *cur == '"') {
+            const char* b = ++cur;
+            while (cur < end && *cur != '"' && *cur != '\n') cur++;
+            if (cur >= end || *cur != '"') return fail("unterminated string");
+            ins.msg.assign(b, (size_t)(cur - b));
+            cur++;
+            skip_space();
+            if (cur < end && *cur == '+') {
+                cur++;
+                const char* vb; size_t vn;
+                if (!ident(vb, vn)) return false;
+                ins.print_var.assign(vb, vn);
+            }
         } else {
-            std::cout << "Error: could not open file '" << out_file << "' for writing.\n";
+            const char* vb; size_t vn;
+            if (!ident(vb, vn)) return false;
+            ins.print_var.assign(vb, vn);
+        }
+        return true;
+    }
+
+    bool parse_instruction(Program& out, int depth) {
+        const char* b; size_t n;
+        if (!ident(b, n)) return false;
+        if (!expect('(')) return false;
+
+        Instruction ins;
+        if (word_is(b, n, "PRINT")) {
+            ins.type = InstrType::PRINT;
+            if (!parse_print(ins)) return false;
+        } else if (word_is(b, n, "DECLARE")) {
+            ins.type = InstrType::DECLARE;
+            const char* vb; size_t vn;
+            uint32_t v;
+            if (!ident(vb, vn) || !expect(',') || !number(v)) return false;
+            ins.var.assign(vb, vn);
+            ins.value = v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+        } else if (word_is(b, n, "ADD") || word_is(b, n, "SUBTRACT")) {
+            ins.type = (n == 3) ? InstrType::ADD : InstrType::SUBTRACT;
+            const char* vb; size_t vn;
+            if (!ident(vb, vn)) return false;
+            ins.var1.assign(vb, vn);
+            if (!expect(',') || !operand(ins.var2, ins.var2_is_literal, ins.lit2)) return false;
+            if (!expect(',') || !operand(ins.var3, ins.var3_is_literal, ins.lit3)) return false;
+        } else if (word_is(b, n, "SLEEP")) {
+            ins.type = InstrType::SLEEP;
+            uint32_t v;
+            if (!number(v)) return false;
+            ins.sleep_ticks = v > 0xFF ? 0xFF : (uint8_t)v;
+        } else if (word_is(b, n, "FOR")) {
+            ins.type = InstrType::FOR_;
+            if (depth >= kMaxForDepth) return fail("FOR nested deeper than " + std::to_string(kMaxForDepth) + " levels");
+            if (!expect('[') || !parse_block(ins.body, ']', depth + 1)) return false;
+            if (!expect(',') || !number(ins.repeats)) return false;
+        } else {
+            return fail("unknown instruction '" + std::string(b, n) + "'");
         }
+
+        if (!expect(')')) return false;
+        out.push_back(std::move(ins));
+        return true;
+    }
+
+    // Parse instructions until 'terminator' (or end of input when terminator is 0)
+    bool parse_block(Program& out, char terminator, int depth) {
+        while (true) {
+            skip_space();
+            if (cur >= end) {
+                return terminator == 0 ? true : fail(std::string("missing '") + terminator + "'");
+            }
+            if (*cur == terminator) {
+                cur++;
+                return true;
+            }
+            if (!parse_instruction(out, depth)) return false;
+            skip_space();
+            if (cur < end && (*cur == ';' || *cur == ',')) cur++;
+        }
+    }
+};
+
+// Parse a program from source text; on failure returns nullptr and sets 'error'
+static ProgramPtr parse_program(const char* data, size_t size, bool optimize, std::string& error) {
+    ProgramParser parser(data, size);
+    Program prog;
+    if (!parser.parse_block(prog, 0, 0)) {
+        error = parser.error;
+        return nullptr;
+    }
+    if (prog.empty()) {
+        error = "program has no instructions";
+        return nullptr;
+    }
+    return finalize_program(std::move(prog), optimize);
+}
+
+// 64-bit FNV-1a, used to key the program cache by file contents
+static uint64_t fnv1a64(const char* data, size_t size) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= (unsigned char)data[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Parsed programs keyed by content hash; the source is kept to rule out collisions.
+// Shared by every emulator instance, optimized and plain versions are cached separately.
+struct CachedProgram {
+    std::string source;
+    bool optimized;
+    ProgramPtr program;
+};
+std::unordered_map<uint64_t, CachedProgram> g_program_cache;
+std::mutex g_program_cache_mtx;
+
+// Load a program file, parsing it only if the same contents have not been seen before
+static ProgramPtr load_program_file(const std::string& path, bool optimize, std::string& error) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        error = "could not open file '" + path + "'";
+        return nullptr;
+    }
+    std::string source;
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (size > 0) {
+        source.resize((size_t)size);
+        in.read(&source[0], size);
+        source.resize((size_t)in.gcount());
+    }
+
+    uint64_t h = fnv1a64(source.data(), source.size()) * 2 + (optimize ? 1 : 0);
+    {
+        std::lock_guard<std::mutex> lk(g_program_cache_mtx);
+        auto it = g_program_cache.find(h);
+        if (it != g_program_cache.end() && it->second.optimized == optimize && it->second.source == source) {
+            return it->second.program;
+        }
+    }
+
+    ProgramPtr prog = parse_program(source.data(), source.size(), optimize, error);
+    if (prog == nullptr) {
+        error = path + ", " + error;
+        return nullptr;
     }
+
+    std::lock_guard<std::mutex> lk(g_program_cache_mtx);
+    g_program_cache[h] = CachedProgram{std::move(source), optimize, prog};
+    return prog;
 }
 
 // Enum to signal the result of an instruction
 enum class ExecStatus { OK, SLEEP, FINISHED };
 
 // helper function to execute instructions
-ExecStatus execute_instruction(PseudoProcess& p, Instruction& instr) {
+ExecStatus execute_instruction(PseudoProcess& p, const Instruction& instr) {
     
     switch (instr.type) {
         case InstrType::PRINT: {
-            // Check for variable printing, e.g., PRINT ("Value from: " +x)
-            size_t var_pos = instr.msg.find("+x");
-            if (var_pos != std::string::npos && instr.msg.find("\"") < var_pos) {
-                 // Found "..." +x
-                 std::string base_msg = instr.msg.substr(0, var_pos);
-                 // Clean up quotes and " +"
-                 base_msg.erase(std::remove(base_msg.begin(), base_msg.end(), '"'), base_msg.end());
-                 if (base_msg.size() > 2 && base_msg.substr(base_msg.size() - 2) == " +") {
-                    base_msg = base_msg.substr(0, base_msg.size() - 2);
-                 }
-
-                 uint16_t val = read_val(p, "x", false, 0); // Spec example hardcodes 'x'
-                 p.log.push_back(base_msg + std::to_string(val));
+            // e.g. PRINT("Value from: " + x) appends the current value of x
+            if (instr.print_var.empty()) {
+                p.log.push_back(instr.msg);
             } else {
-                 // Simple print, e.g. "Hello World"
-                 std::string clean_msg = instr.msg;
-                 clean_msg.erase(std::remove(clean_msg.begin(), clean_msg.end(), '"'), clean_msg.end());
-                 p.log.push_back(clean_msg);
+                uint16_t val = read_val(p, instr.print_var, false, 0);
+                p.log.push_back(instr.msg + std::to_string(val));
             }
             break;
         }
@@ -354,131 +677,1875 @@ ExecStatus execute_instruction(PseudoProcess& p, Instruction& instr) {
             break;
         }
 
-        case InstrType::SLEEP:
-            p.sleep_left = instr.sleep_ticks;
-            return ExecStatus::SLEEP; // Signal to scheduler
+        case InstrType::SLEEP:
+            p.sleep_left = instr.sleep_ticks;
+            return ExecStatus::SLEEP; // Signal to scheduler
+
+        case InstrType::FOR_:
+            // handled by core function
+            break;
+    }
+    return ExecStatus::OK;
+}
+
+// Scheduling trace recorder
+// Each core writes fixed-size binary records into its own ring buffer (the last ring is shared by
+// the clock and process creation). Rings overwrite their oldest records when full, so a long trace
+// keeps the most recent events. Nothing is formatted until the trace is exported.
+enum class TraceEvt : uint8_t { CREATE, DISPATCH, PREEMPT, SLEEP, WAKE, FINISH };
+
+// Raw timestamp for trace records: the TSC on x86-64, which is several times cheaper to read than
+// steady_clock::now(). Stamps are converted to nanoseconds on export, scaled between calibration
+// points taken at trace-start and trace-stop.
+static inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct TraceRecord {
+    uint64_t ts_ns; // trace_clock() when recorded; nanoseconds since trace-start once exported
+    int32_t pid;
+    int32_t tick;   // CPU tick when recorded
+    int16_t core;   // -1 for events not raised by a core
+    TraceEvt type;
+};
+
+struct TraceRing {
+    static constexpr size_t kCapacity = 1 << 16; // records, power of two
+
+    std::unique_ptr<TraceRecord[]> buf{new TraceRecord[kCapacity]};
+    alignas(64) std::atomic<uint64_t> head{0};
+    std::atomic<int> writers{0};
+};
+
+class Tracer {
+public:
+    explicit Tracer(const std::atomic<int>& ticks) : ticks(ticks) {}
+
+    bool enabled() const { return on.load(); }
+
+    inline void event(TraceEvt type, int core, int pid) {
+        // acquire pairs with the store in start(), so the rings it built are visible here
+        if (!on.load(std::memory_order_acquire)) return;
+
+        size_t idx = (core >= 0 && core < (int)rings.size() - 1) ? (size_t)core : rings.size() - 1;
+        TraceRing& ring = *rings[idx];
+
+        // re-check after registering as a writer so stop() never exports a half-written record
+        ring.writers.fetch_add(1);
+        if (on.load()) {
+            // a core's ring has a single writer; only the shared system ring needs an atomic claim
+            uint64_t slot;
+            if (idx + 1 < rings.size()) {
+                slot = ring.head.load(std::memory_order_relaxed);
+                ring.head.store(slot + 1, std::memory_order_relaxed);
+            } else {
+                slot = ring.head.fetch_add(1, std::memory_order_relaxed);
+            }
+            TraceRecord& r = ring.buf[slot & (TraceRing::kCapacity - 1)];
+            r.ts_ns = trace_clock();
+            r.pid = pid;
+            r.tick = ticks.load(std::memory_order_relaxed);
+            r.core = (int16_t)core;
+            r.type = type;
+        }
+        ring.writers.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Clear the rings and start recording (rings are allocated on first use)
+    void start(int num_cores) {
+        if (rings.empty()) {
+            for (int i = 0; i <= num_cores; ++i) {
+                rings.push_back(std::unique_ptr<TraceRing>(new TraceRing()));
+            }
+        }
+        for (auto& ring : rings) ring->head.store(0);
+        t0 = std::chrono::steady_clock::now();
+        clock0 = trace_clock();
+        on.store(true);
+    }
+
+    // Stop recording and wait for writers that are still inside event()
+    void stop() {
+        on.store(false);
+        for (auto& ring : rings) {
+            while (ring->writers.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+        t1 = std::chrono::steady_clock::now();
+        clock1 = trace_clock();
+    }
+
+    size_t export_json(const std::string& out_file, const std::unordered_map<int, std::string>& names,
+                       std::string& error) const;
+
+private:
+    const std::atomic<int>& ticks;
+    std::atomic<bool> on{false};
+    std::vector<std::unique_ptr<TraceRing>> rings; // one per core + 1 system ring
+    std::chrono::steady_clock::time_point t0, t1; // calibration points for trace_clock() stamps
+    uint64_t clock0{0}, clock1{0};
+};
+
+//HELPER FUNCTION
+static std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+// Export the recorded trace as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Process 1 has one row per core showing which pid ran there; process 2 has one row per pid
+// showing time spent waiting in the ready queue and sleeping. Returns the number of records.
+size_t Tracer::export_json(const std::string& out_file, const std::unordered_map<int, std::string>& names,
+                           std::string& error) const {
+    std::vector<TraceRecord> recs;
+    for (auto& ring : rings) {
+        uint64_t head = ring->head.load();
+        uint64_t first = head > TraceRing::kCapacity ? head - TraceRing::kCapacity : 0;
+        for (uint64_t i = first; i < head; ++i) {
+            recs.push_back(ring->buf[i & (TraceRing::kCapacity - 1)]);
+        }
+    }
+    std::stable_sort(recs.begin(), recs.end(),
+        [](const TraceRecord& a, const TraceRecord& b) { return a.ts_ns < b.ts_ns; });
+
+    // raw stamps to nanoseconds since trace-start
+    double ns_per_stamp = clock1 > clock0
+        ? std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)(clock1 - clock0) : 0.0;
+    for (auto& r : recs) {
+        r.ts_ns = r.ts_ns > clock0 ? (uint64_t)((r.ts_ns - clock0) * ns_per_stamp) : 0;
+    }
+
+    std::ofstream ofs(out_file, std::ios::out | std::ios::trunc);
+    if (!ofs.is_open()) {
+        error = "could not open file '" + out_file + "' for writing";
+        return 0;
+    }
+
+    auto us = [](uint64_t ns) {
+        std::ostringstream s;
+        s << ns / 1000 << '.' << (char)('0' + ns % 1000 / 100) << (char)('0' + ns % 100 / 10) << (char)('0' + ns % 10);
+        return s.str();
+    };
+    auto pname = [&](int pid) {
+        auto it = names.find(pid);
+        return it != names.end() ? json_escape(it->second) : "pid " + std::to_string(pid);
+    };
+
+    bool first_evt = true;
+    auto emit = [&](const std::string& body) {
+        ofs << (first_evt ? "\n" : ",\n") << "{" << body << "}";
+        first_evt = false;
+    };
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    emit("\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU cores\"}");
+    emit("\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"Processes\"}");
+    for (int c = 0; c < (int)rings.size() - 1; ++c) {
+        emit("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(c) +
+             ",\"args\":{\"name\":\"core " + std::to_string(c) + "\"}");
+    }
+
+    struct Open { int pid; uint64_t since; int tick; };
+    std::unordered_map<int, Open> on_core;   // core -> running slice
+    std::unordered_map<int, Open> in_ready;  // pid -> waiting since
+    std::unordered_map<int, Open> in_sleep;  // pid -> sleeping since
+    std::unordered_map<int, bool> seen_pid;
+
+    auto slice = [&](int tpid, int tid, const std::string& name, const Open& o, uint64_t end_ns) {
+        emit("\"name\":\"" + name + "\",\"ph\":\"X\",\"pid\":" + std::to_string(tpid) + ",\"tid\":" + std::to_string(tid) +
+             ",\"ts\":" + us(o.since) + ",\"dur\":" + us(end_ns - o.since) +
+             ",\"args\":{\"pid\":" + std::to_string(o.pid) + ",\"tick\":" + std::to_string(o.tick) + "}");
+    };
+
+    for (const auto& r : recs) {
+        if (!seen_pid[r.pid]) {
+            seen_pid[r.pid] = true;
+            emit("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":" + std::to_string(r.pid) +
+                 ",\"args\":{\"name\":\"" + pname(r.pid) + "\"}");
+        }
+
+        switch (r.type) {
+            case TraceEvt::CREATE:
+                in_ready[r.pid] = {r.pid, r.ts_ns, r.tick};
+                emit("\"name\":\"create\",\"ph\":\"i\",\"s\":\"t\",\"pid\":2,\"tid\":" + std::to_string(r.pid) + ",\"ts\":" + us(r.ts_ns));
+                break;
+            case TraceEvt::DISPATCH: {
+                auto it = in_ready.find(r.pid);
+                if (it != in_ready.end()) {
+                    slice(2, r.pid, "ready", it->second, r.ts_ns);
+                    in_ready.erase(it);
+                }
+                on_core[r.core] = {r.pid, r.ts_ns, r.tick};
+                break;
+            }
+            case TraceEvt::PREEMPT:
+            case TraceEvt::SLEEP:
+            case TraceEvt::FINISH: {
+                auto it = on_core.find(r.core);
+                if (it != on_core.end()) {
+                    slice(1, r.core, pname(r.pid), it->second, r.ts_ns);
+                    on_core.erase(it);
+                }
+                if (r.type == TraceEvt::PREEMPT) in_ready[r.pid] = {r.pid, r.ts_ns, r.tick};
+                if (r.type == TraceEvt::SLEEP) in_sleep[r.pid] = {r.pid, r.ts_ns, r.tick};
+                if (r.type == TraceEvt::FINISH) {
+                    emit("\"name\":\"finish\",\"ph\":\"i\",\"s\":\"t\",\"pid\":2,\"tid\":" + std::to_string(r.pid) + ",\"ts\":" + us(r.ts_ns));
+                }
+                break;
+            }
+            case TraceEvt::WAKE: {
+                auto it = in_sleep.find(r.pid);
+                if (it != in_sleep.end()) {
+                    slice(2, r.pid, "sleep", it->second, r.ts_ns);
+                    in_sleep.erase(it);
+                }
+                in_ready[r.pid] = {r.pid, r.ts_ns, r.tick};
+                break;
+            }
+        }
+    }
+    ofs << "\n]}\n";
+    return recs.size();
+}
+
+// Log-bucketed latency histogram (HDR-style). Values below 16 get exact buckets; above that each
+// power of two is split into 16 linear sub-buckets, so a percentile is off by at most ~6%.
+struct LatencyHistogram {
+    static constexpr int kSubBits = 4;
+    static constexpr uint64_t kSub = 1ull << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * (int)kSub;
+
+    uint64_t counts[kBuckets] = {};
+    uint64_t total{0};
+    uint64_t max_value{0};
+
+    static int bucket_of(uint64_t v) {
+        if (v < kSub) return (int)v;
+        int shift = 63 - __builtin_clzll(v) - kSubBits;
+        return (shift + 1) * (int)kSub + (int)((v >> shift) - kSub);
+    }
+
+    // highest value that falls into bucket 'idx'
+    static uint64_t bucket_top(int idx) {
+        if (idx < (int)kSub) return (uint64_t)idx;
+        int shift = idx / (int)kSub - 1;
+        uint64_t sub = (uint64_t)(idx % (int)kSub) + kSub;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t v) {
+        counts[bucket_of(v)]++;
+        total++;
+        if (v > max_value) max_value = v;
+    }
+
+    // q in [0, 1]
+    uint64_t percentile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucket_top(i), max_value);
+        }
+        return max_value;
+    }
+};
+
+// Latency statistics of finished processes, kept per scheduling policy. Times are in microseconds.
+struct PolicyStats {
+    LatencyHistogram turnaround; // creation to finish
+    LatencyHistogram waiting;    // total time spent in the ready queue
+    LatencyHistogram response;   // creation to first dispatch
+    uint64_t finished{0};
+    int first_arrival_tick{-1};
+    int last_finish_tick{0};
+
+    // processes finished per 1k ticks, from the first arrival to the last finish
+    double throughput() const {
+        int span = last_finish_tick - first_arrival_tick;
+        if (span < 1) span = 1;
+        return (double)finished * 1000.0 / span;
+    }
+};
+
+static uint64_t to_us(std::chrono::steady_clock::duration d) {
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    return us < 0 ? 0 : (uint64_t)us;
+}
+
+// Ready queues: a shared FIFO plus one local queue per core used by soft affinity.
+// Entries carry a sequence number so a core can serve its local queue and the shared
+// queue in arrival order.
+struct ReadyEntry {
+    int pid;
+    uint64_t seq;
+};
+
+// Per-core dispatch counters, written only by the owning core
+struct CoreStats {
+    std::atomic<uint64_t> dispatches{0};
+    std::atomic<uint64_t> migrations_in{0}; // dispatches of a process that last ran on another core
+    std::atomic<uint64_t> instructions{0};  // instruction cycles executed, including fast-forwarded loops
+    std::atomic<uint64_t> busy_ns{0};       // host time spent running quanta
+    std::atomic<uint64_t> overhead_ns{0};   // host time spent dequeuing, finding and requeuing processes
+    std::atomic<int> current_pid{-1};       // process on the core, -1 when idle
+    std::atomic<bool> pinned{false};
+};
+
+// Process classes for the adaptive quantum
+enum class ProcClass : uint8_t { CPU_BOUND, SLEEPER };
+constexpr size_t NUM_PROC_CLASSES = 2;
+static const char* const proc_class_names[NUM_PROC_CLASSES] = {"cpu-bound", "sleeper"};
+
+// Adaptive round-robin quantum of one process class. Cores add the measured switch overhead
+// and useful run time of each dispatch; the clock retunes the quantum from the current window.
+struct QuantumTuner {
+    std::atomic<int> quantum{0};
+
+    // window since the last retune
+    std::atomic<uint64_t> overhead_ns{0};
+    std::atomic<uint64_t> useful_ns{0};
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> dispatches{0};
+    std::atomic<uint64_t> expired{0};       // dispatches that used their whole quantum
+
+    // since the emulator started
+    std::atomic<uint64_t> total_overhead_ns{0};
+    std::atomic<uint64_t> total_useful_ns{0};
+    std::atomic<uint64_t> total_cycles{0};
+    std::atomic<uint64_t> total_dispatches{0};
+};
+
+// Point-in-time copy of the emulator's counters, taken without any lock. Fields are read one
+// by one, so they can be a few events apart from each other.
+struct CounterSnapshot {
+    struct Core {
+        uint64_t dispatches;
+        uint64_t migrations_in;
+        uint64_t instructions;
+        uint64_t busy_ns;
+        int pid;        // process on the core, -1 when idle
+        bool busy;
+    };
+
+    std::chrono::steady_clock::time_point taken;
+    int ticks{0};
+    uint64_t created{0};
+    uint64_t finished{0};
+    int64_t ready{0};
+    int64_t sleeping{0};
+    int running{0};
+    bool generating{false};
+    uint64_t instructions{0};
+    int quantum[NUM_PROC_CLASSES]{};
+    std::vector<Core> cores;
+};
+
+// One row of the short process list published for the live view
+struct ProcessRow {
+    int pid;
+    std::string name;
+    const char* state;  // RUNNING, SLEEPING or READY
+    int last_core;      // -1 if never dispatched
+    size_t line;        // current top-level instruction
+    size_t lines;
+    long long uptime_ms;
+};
+using ProcessRowsPtr = std::shared_ptr<const std::vector<ProcessRow>>;
+
+class Emulator;
+
+// Metrics and control server on a Unix domain socket (Linux only). One epoll thread serves every
+// client without blocking. A client either sends "GET /metrics" over HTTP and gets the Prometheus
+// text back, or sends newline-terminated commands: "metrics", "scheduler-start", "scheduler-stop",
+// "quit". Metrics come from Emulator::snapshot(), so scraping never takes processes_mtx.
+class MetricsServer {
+public:
+    explicit MetricsServer(Emulator& emu) : emu(emu) {}
+    ~MetricsServer() { stop(); }
+
+    bool start(const std::string& socket_path, std::string& error);
+    void stop();
+    bool listening() const { return on.load(); }
+
+    std::string metrics_text();   // Prometheus text exposition of the current counters
+
+private:
+    struct Client {
+        std::string in;
+        std::string out;
+        bool close_after_write{false};
+    };
+
+    void serve();
+    void handle_input(int fd, Client& c);
+    bool flush(int fd, Client& c);   // false once the client should be closed
+    void close_client(int fd);
+    std::string run_command(const std::string& line, bool& close_after);
+
+    Emulator& emu;
+    std::string path;
+    std::atomic<bool> on{false};
+    std::thread worker;
+    int listen_fd{-1};
+    int epoll_fd{-1};
+    int wake_fd{-1};
+    std::unordered_map<int, Client> clients;
+
+    // previous scrape, for the per-second rates and utilization
+    // the rates are computed over a fixed window the server thread advances every
+    // kRateWindow, so they do not depend on how often or by how many clients it is scraped
+    static constexpr std::chrono::seconds kRateWindow{1};
+    void advance_window();
+    std::mutex window_mtx;
+    CounterSnapshot window_start;
+    CounterSnapshot window_end;
+};
+
+// One simulated machine: its configuration, process table, ready queues, statistics, tracer and
+// the threads that run it (CPU cores, the clock and the batch generator). Instances share no
+// state, so several can run side by side in one OS process.
+class Emulator {
+public:
+    explicit Emulator(const Config& cfg);
+    ~Emulator();
+
+    void start();                 // launch the CPU cores and the clock
+    void stop();                  // stop the generator, cores and clock and join them
+
+    bool start_generator();       // false if it is already running
+    bool stop_generator();        // false if it was not running
+
+    // variants for the metrics server, which must never wait for the generator thread to exit
+    bool try_start_generator(std::string& error);
+    bool request_generator_stop(); // only clears the flag; the next start or stop joins the thread
+    bool generating_processes() const { return generating.load(); }
+
+    template <typename MakeFn>
+    int create_processes(int count, MakeFn make);
+    int create_process(const std::string& pname, ProgramPtr program);
+    int create_generated_processes(int count);
+
+    std::string utilization_report();
+    size_t export_trace(const std::string& out_file, std::string& error);
+    CounterSnapshot snapshot() const;
+
+    // Short process list for the live view. While process_rows_watchers is non-zero the clock
+    // republishes it every tick, so readers get a copy without taking processes_mtx.
+    static constexpr size_t kProcessRows = 10;
+    std::atomic<int> process_rows_watchers{0};
+    ProcessRowsPtr process_rows() const { return std::atomic_load(&published_rows); }
+
+    const Config config;
+
+    // system clock
+    std::atomic<int> cpu_cycles{0};
+
+    // process table
+    std::vector<PseudoProcess> processes;
+    std::mutex processes_mtx;
+    std::atomic<int> next_pid{1};
+
+    // ready queues, all guarded by ready_queue_mtx
+    std::deque<ReadyEntry> ready_queue;
+    std::vector<std::deque<ReadyEntry>> core_queues;
+    uint64_t ready_seq = 0;
+    std::mutex ready_queue_mtx;
+
+    std::unique_ptr<CoreStats[]> core_stats;
+    Tracer tracer{cpu_cycles};
+
+    // process counts kept with relaxed atomics next to the locked state they mirror
+    std::atomic<uint64_t> created_count{0};
+    std::atomic<uint64_t> finished_count{0};
+    std::atomic<int64_t> ready_count{0};
+    std::atomic<int64_t> sleeping_count{0};
+
+    QuantumTuner tuners[NUM_PROC_CLASSES];
+    std::chrono::steady_clock::time_point started_at;
+
+    MetricsServer metrics{*this};
+
+    // latency statistics of finished processes, per scheduling policy
+    std::map<std::string, PolicyStats> policy_stats;
+    std::mutex stats_mtx;
+
+private:
+    void cpu_core_function(int core_id);
+    void clock_thread();
+    void generator_thread();
+
+    void enqueue_ready_locked(int pid, int last_core);
+    int dequeue_ready_locked(int core_id);
+
+    void retune_quantum(QuantumTuner& t);
+    void publish_process_rows_locked();
+    void record_finished(const PseudoProcess& p);
+    void report_latency_stats(std::ostringstream& oss);
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> generating{false};
+    std::atomic<bool> generator_done{true}; // the generator thread has returned and only needs joining
+    ProcessRowsPtr published_rows;          // accessed with std::atomic_load/atomic_store only
+    std::mutex generator_mtx;     // serializes generator start/stop from the console and the metrics server
+    std::vector<std::thread> core_threads;
+    std::thread clock;
+    std::thread generator;
+};
+
+Emulator::Emulator(const Config& cfg)
+    : config(cfg),
+      core_queues(cfg.num_cpu > 0 ? cfg.num_cpu : 0),
+      core_stats(new CoreStats[cfg.num_cpu > 0 ? cfg.num_cpu : 1]) {
+    if (config.adaptive_quantum) {
+        for (auto& t : tuners) {
+            t.quantum = std::max(config.quantum_min, std::min(config.quantum_max, config.quantum_cycles));
+        }
+    }
+}
+
+Emulator::~Emulator() {
+    stop();
+}
+
+void Emulator::start() {
+    if (running.exchange(true)) return;
+    started_at = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.num_cpu; ++i) {
+        core_threads.emplace_back(&Emulator::cpu_core_function, this, i);
+    }
+    clock = std::thread(&Emulator::clock_thread, this);
+}
+
+void Emulator::stop() {
+    metrics.stop();
+    stop_generator();
+    running = false;
+    for (auto& t : core_threads) {
+        if (t.joinable()) t.join();
+    }
+    core_threads.clear();
+    if (clock.joinable()) clock.join();
+    if (tracer.enabled()) tracer.stop();
+}
+
+bool Emulator::start_generator() {
+    std::lock_guard<std::mutex> lk(generator_mtx);
+    if (generating) return false;
+    if (generator.joinable()) {
+        generator.join(); // one asked to stop by the metrics server
+    }
+    generating = true;
+    generator_done = false;
+    generator = std::thread(&Emulator::generator_thread, this);
+    return true;
+}
+
+// Start the generator unless that means waiting: for the mutex, or for a generator that was
+// asked to stop but has not returned yet
+bool Emulator::try_start_generator(std::string& error) {
+    std::unique_lock<std::mutex> lk(generator_mtx, std::try_to_lock);
+    if (lk.owns_lock() && generating) {
+        error = "Scheduler already running.";
+        return false;
+    }
+    if (!lk.owns_lock() || (generator.joinable() && !generator_done)) {
+        error = "Scheduler is still stopping, try again.";
+        return false;
+    }
+    if (generator.joinable()) {
+        generator.join(); // already returned
+    }
+    generating = true;
+    generator_done = false;
+    generator = std::thread(&Emulator::generator_thread, this);
+    return true;
+}
+
+bool Emulator::request_generator_stop() {
+    return generating.exchange(false);
+}
+
+// Scheduler Stop
+bool Emulator::stop_generator() {
+    std::lock_guard<std::mutex> lk(generator_mtx);
+
+    // Signal the generator to stop
+    bool was_generating = generating.exchange(false);
+
+    // If thread is joinable (we created a non-detached thread), join it to clean up
+    if (generator.joinable()) {
+        try {
+            generator.join();
+        } catch (...) {
+            // swallow exceptions to avoid termination; nothing much to do here
+        }
+    }
+    return was_generating;
+}
+
+size_t Emulator::export_trace(const std::string& out_file, std::string& error) {
+    std::unordered_map<int, std::string> names;
+    {
+        std::lock_guard<std::mutex> lk(processes_mtx);
+        for (const auto& p : processes) names[p.pid] = p.name;
+    }
+    return tracer.export_json(out_file, names, error);
+}
+
+CounterSnapshot Emulator::snapshot() const {
+    CounterSnapshot snap;
+    snap.taken = std::chrono::steady_clock::now();
+    snap.ticks = cpu_cycles.load(std::memory_order_relaxed);
+    snap.created = created_count.load(std::memory_order_relaxed);
+    snap.finished = finished_count.load(std::memory_order_relaxed);
+    snap.ready = std::max<int64_t>(0, ready_count.load(std::memory_order_relaxed));
+    snap.sleeping = std::max<int64_t>(0, sleeping_count.load(std::memory_order_relaxed));
+    snap.generating = generating.load(std::memory_order_relaxed);
+    bool adaptive = config.adaptive_quantum && config.scheduler == "rr";
+    for (size_t c = 0; c < NUM_PROC_CLASSES; ++c) {
+        snap.quantum[c] = adaptive ? tuners[c].quantum.load(std::memory_order_relaxed) : config.quantum_cycles;
+    }
+    for (int i = 0; i < config.num_cpu; ++i) {
+        const CoreStats& cs = core_stats[i];
+        CounterSnapshot::Core c;
+        c.dispatches = cs.dispatches.load(std::memory_order_relaxed);
+        c.migrations_in = cs.migrations_in.load(std::memory_order_relaxed);
+        c.instructions = cs.instructions.load(std::memory_order_relaxed);
+        c.busy_ns = cs.busy_ns.load(std::memory_order_relaxed);
+        c.pid = cs.current_pid.load(std::memory_order_relaxed);
+        c.busy = c.pid != -1;
+        if (c.busy) snap.running++;
+        snap.instructions += c.instructions;
+        snap.cores.push_back(c);
+    }
+    return snap;
+}
+
+// Queue a process, preferring the local queue of the core it last ran on unless that
+// core is overloaded; ready_queue_mtx must be held
+void Emulator::enqueue_ready_locked(int pid, int last_core) {
+    ReadyEntry e{pid, ready_seq++};
+    ready_count.fetch_add(1, std::memory_order_relaxed);
+    if (config.soft_affinity && last_core >= 0 && last_core < (int)core_queues.size()) {
+        size_t shortest = core_queues[last_core].size();
+        for (const auto& q : core_queues) shortest = std::min(shortest, q.size());
+        if (core_queues[last_core].size() <= shortest + (size_t)config.affinity_slack) {
+            core_queues[last_core].push_back(e);
+            return;
+        }
+    }
+    ready_queue.push_back(e);
+}
+
+// Take the next process for 'core_id': the older of its local queue head and the shared queue
+// head, otherwise steal from the longest local queue of another core. Returns -1 if all are
+// empty; ready_queue_mtx must be held
+int Emulator::dequeue_ready_locked(int core_id) {
+    std::deque<ReadyEntry>* src = nullptr;
+    if (core_id < (int)core_queues.size() && !core_queues[core_id].empty()) {
+        src = &core_queues[core_id];
+    }
+    if (!ready_queue.empty() && (src == nullptr || ready_queue.front().seq < src->front().seq)) {
+        src = &ready_queue;
+    }
+    if (src == nullptr) {
+        for (auto& q : core_queues) {
+            if (!q.empty() && (src == nullptr || q.size() > src->size())) src = &q;
+        }
+    }
+    if (src == nullptr) return -1;
+
+    int pid = src->front().pid;
+    src->pop_front();
+    ready_count.fetch_sub(1, std::memory_order_relaxed);
+    return pid;
+}
+
+// Generated processes are named p01, p02, ..., p10, ...
+static std::string generated_name(int pid) {
+    std::string name = pid < 10 ? "p0" : "p";
+    name += std::to_string(pid);
+    return name;
+}
+
+// Create 'count' processes with consecutive pids and queue them. The pid range is reserved
+// up front, the processes are built outside any lock by make(proc) (which fills in the name
+// and program), then published with one lock of the process table and one of the ready
+// queues. Returns the first pid.
+template <typename MakeFn>
+int Emulator::create_processes(int count, MakeFn make) {
+    if (count <= 0) return -1;
+    int first_pid = next_pid.fetch_add(count);
+
+    auto now = std::chrono::steady_clock::now();
+    int tick = cpu_cycles.load();
+    std::vector<PseudoProcess> batch(count);
+    for (int i = 0; i < count; ++i) {
+        PseudoProcess& proc = batch[i];
+        proc.pid = first_pid + i;
+        proc.start_time = now;
+        proc.ready_since = now;
+        proc.arrival_tick = tick;
+        proc.running = false;
+        make(proc);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(processes_mtx);
+        size_t needed = processes.size() + batch.size();
+        if (processes.capacity() < needed) {
+            processes.reserve(std::max(needed, processes.capacity() * 2));
+        }
+        for (auto& proc : batch) {
+            tracer.event(TraceEvt::CREATE, -1, proc.pid);
+            processes.push_back(std::move(proc));
+        }
+        created_count.fetch_add((uint64_t)count, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lk(ready_queue_mtx);
+        for (int i = 0; i < count; ++i) {
+            enqueue_ready_locked(first_pid + i, -1);
+        }
+    }
+    return first_pid;
+}
+
+// Create a process and put it on the ready queue; returns its pid
+int Emulator::create_process(const std::string& pname, ProgramPtr program) {
+    return create_processes(1, [&](PseudoProcess& proc) {
+        proc.name = pname;
+        proc.program = std::move(program);
+    });
+}
+
+// Create 'count' processes running the default program, as the batch generator does
+int Emulator::create_generated_processes(int count) {
+    return create_processes(count, [this](PseudoProcess& proc) {
+        proc.name = generated_name(proc.pid);
+        proc.program = finalize_program(make_default_program(proc.name), config.optimize_programs);
+    });
+}
+
+
+//intialize TO-DO: create this (already done in the command_interpreter_thread)
+
+//screen marquee logic TO-DO: create this
+
+// Scheduler Start (batch generator thread)
+void Emulator::generator_thread() {
+    long freq = config.batch_process_freq;
+    if (freq <= 0) freq = 1;
+
+    long long last_tick = cpu_cycles.load();
+
+    while (generating && running) {
+        long long cur = cpu_cycles.load();
+        if (cur - last_tick >= freq) {
+
+            int running_count = 0;
+
+            // count running processes; the ready queues' size is kept in ready_count
+            {
+                std::lock_guard<std::mutex> lk1(processes_mtx);
+                for (auto& p : processes) {
+                    if (p.running && !p.finished) running_count++;
+                }
+            }
+            int queued = (int)std::max<int64_t>(0, ready_count.load(std::memory_order_relaxed));
+
+            int active_total = running_count + queued;
+
+            // Only generate if fewer than num_cpu active processes
+            if (active_total < config.num_cpu) {
+                int to_generate = config.num_cpu - active_total;
+                create_generated_processes(to_generate);
+            }
+
+            last_tick = cur;
+        }
+
+        // give CPU threads time to pick up work
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+
+    generating = false;
+    generator_done = true;
+}
+
+// Called with processes_mtx held when a process finishes
+void Emulator::record_finished(const PseudoProcess& p) {
+    int tick = cpu_cycles.load();
+    std::lock_guard<std::mutex> lk(stats_mtx);
+    PolicyStats& st = policy_stats[config.scheduler];
+    st.turnaround.record(to_us(p.finish_time - p.start_time));
+    st.waiting.record(to_us(p.wait_time));
+    st.response.record(to_us(p.first_dispatch - p.start_time));
+    st.finished++;
+    if (st.first_arrival_tick < 0 || p.arrival_tick < st.first_arrival_tick) st.first_arrival_tick = p.arrival_tick;
+    if (tick > st.last_finish_tick) st.last_finish_tick = tick;
+}
+
+// Append the p50/p95/p99 table for every policy that has finished processes
+void Emulator::report_latency_stats(std::ostringstream& oss) {
+    std::lock_guard<std::mutex> lk(stats_mtx);
+    if (policy_stats.empty()) return;
+
+    auto ms = [](uint64_t us) {
+        std::ostringstream s;
+        s.setf(std::ios::fixed);
+        s.precision(2);
+        s << us / 1000.0;
+        return s.str();
+    };
+
+    for (const auto& kv : policy_stats) {
+        const PolicyStats& st = kv.second;
+
+        std::ostringstream tp;
+        tp.setf(std::ios::fixed);
+        tp.precision(2);
+        tp << st.throughput();
+
+        oss << "\nScheduler \"" << kv.first << "\": " << st.finished << " finished, throughput "
+            << tp.str() << " processes per 1k ticks\n";
+        oss << "LATENCY(ms)\tp50\tp95\tp99\n";
+        const std::pair<const char*, const LatencyHistogram*> rows[] = {
+            {"Turnaround", &st.turnaround}, {"Waiting", &st.waiting}, {"Response", &st.response}};
+        for (const auto& row : rows) {
+            oss << row.first << '\t' << ms(row.second->percentile(0.50)) << '\t'
+                << ms(row.second->percentile(0.95)) << '\t' << ms(row.second->percentile(0.99)) << '\n';
+        }
+    }
+}
+
+// Report Utilization
+std::string Emulator::utilization_report() {
+    std::lock_guard<std::mutex> lk(processes_mtx);
+    std::ostringstream oss;
+
+    int cores_used = 0;
+    for (const auto& p : processes) {
+        // 'running' == true means it's on a core OR sleeping
+        if (p.running) { 
+            cores_used++;
+        }
+    }
+    int cores_available = config.num_cpu - cores_used;
+    if (cores_available < 0) cores_available = 0; // Safety check
+    
+    double cpu_utilization = 0.0;
+    if (config.num_cpu > 0) {
+        cpu_utilization = (static_cast<double>(cores_used) / config.num_cpu) * 100.0;
+    }
+
+    oss << "CPU utilization: " << (int)cpu_utilization << "%\n";
+    oss << "Cores used: " << cores_used << "\n";
+    oss << "Cores available: " << cores_available << "\n\n";
+
+    // share of busy core time spent switching rather than running instructions
+    auto overhead_pct = [](uint64_t overhead, uint64_t useful) {
+        std::ostringstream s;
+        s.setf(std::ios::fixed);
+        s.precision(1);
+        s << (overhead + useful > 0 ? 100.0 * overhead / (overhead + useful) : 0.0);
+        return s.str();
+    };
+
+    // per-core dispatch, migration and switch overhead counts
+    if (core_stats) {
+        uint64_t total_dispatches = 0;
+        uint64_t total_migrations = 0;
+        uint64_t total_instructions = 0;
+        oss << "CORE\tDISPATCHES\tMIGRATIONS\tOVERHEAD%\tPINNED\n";
+        for (int i = 0; i < config.num_cpu; ++i) {
+            uint64_t d = core_stats[i].dispatches.load(std::memory_order_relaxed);
+            uint64_t m = core_stats[i].migrations_in.load(std::memory_order_relaxed);
+            uint64_t o = core_stats[i].overhead_ns.load(std::memory_order_relaxed);
+            uint64_t b = core_stats[i].busy_ns.load(std::memory_order_relaxed);
+            total_dispatches += d;
+            total_migrations += m;
+            total_instructions += core_stats[i].instructions.load(std::memory_order_relaxed);
+            oss << i << '\t' << d << '\t' << m << '\t' << overhead_pct(o, b) << '\t'
+                << (core_stats[i].pinned ? "yes" : "no") << '\n';
+        }
+        oss << "Migrations: " << total_migrations << " of " << total_dispatches << " dispatches\n";
+
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at).count();
+        oss << "Throughput: " << (long long)(secs > 0 ? total_instructions / secs : 0) << " instruction cycles/s ("
+            << total_instructions << " cycles)\n\n";
+    }
+
+    // quanta picked by the adaptive round robin
+    if (config.adaptive_quantum && config.scheduler == "rr") {
+        oss << "Adaptive quantum: target " << config.target_overhead << "% switch overhead, "
+            << std::max(1, config.quantum_min) << " to " << std::max(std::max(1, config.quantum_min), config.quantum_max)
+            << " cycles\n";
+        oss << "CLASS\tQUANTUM\tDISPATCHES\tCYCLES/DISPATCH\tOVERHEAD%\n";
+        for (size_t c = 0; c < NUM_PROC_CLASSES; ++c) {
+            const QuantumTuner& t = tuners[c];
+            uint64_t d = t.total_dispatches.load(std::memory_order_relaxed);
+            uint64_t cyc = t.total_cycles.load(std::memory_order_relaxed);
+            std::ostringstream per;
+            per.setf(std::ios::fixed);
+            per.precision(1);
+            per << (d > 0 ? (double)cyc / d : 0.0);
+            oss << proc_class_names[c] << '\t' << t.quantum.load() << '\t' << d << '\t' << per.str() << '\t'
+                << overhead_pct(t.total_overhead_ns.load(std::memory_order_relaxed),
+                                t.total_useful_ns.load(std::memory_order_relaxed))
+                << '\n';
+        }
+        oss << '\n';
+    }
+    
+    if (processes.empty()) {
+        oss << "No processes found.\n";
+    } else {
+        oss << "PID\tSTATE\tUPTIME(ms)\tNAME\n";
+        for (const auto& p : processes) {
+            const char* st = p.finished ? "FINISHED" : (p.running ? "RUNNING" : "READY");
+            oss << p.pid << '\t' << st << '\t' << uptime_ms(p) << '\t' << p.name << '\n';
+        }
+    }
+
+    report_latency_stats(oss);
+
+    return oss.str();
+}
+
+// CPU thread function
+void Emulator::cpu_core_function(int core_id) {
+    if (config.pin_cores) {
+        core_stats[core_id].pinned = pin_current_thread(config.pin_first_cpu + core_id);
+    }
+
+    CoreStats& cs = core_stats[core_id];
+    auto ns = [](std::chrono::steady_clock::duration d) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    };
+
+    while (running) {
+        // get process id from ready queue
+        // overhead timers start after each lock is acquired: waiting for it is other cores' work
+        int pid_to_run = -1;
+        std::chrono::steady_clock::time_point pick_start, picked;
+        {
+            std::lock_guard<std::mutex> lk(ready_queue_mtx);
+            pick_start = std::chrono::steady_clock::now();
+            pid_to_run = dequeue_ready_locked(core_id);
+            picked = std::chrono::steady_clock::now();
+        }
+
+        if (pid_to_run == -1) {
+            // if no work to do, sleep and try again
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lk(processes_mtx);
+        auto scan_start = std::chrono::steady_clock::now();
+        
+        // find process
+        PseudoProcess* p = nullptr;
+        for (auto& proc : processes) {
+            if (proc.pid == pid_to_run) {
+                p = &proc;
+                break;
+            }
+        }
+
+        // if process not found or already running/finished, skip
+        if (p == nullptr || p->finished || p->running) {
+            continue;
+        }
+
+        p->running = true;
+        core_stats[core_id].current_pid.store(p->pid, std::memory_order_relaxed);
+        tracer.event(TraceEvt::DISPATCH, core_id, p->pid);
+
+        core_stats[core_id].dispatches.fetch_add(1, std::memory_order_relaxed);
+        if (p->last_core != -1 && p->last_core != core_id) {
+            core_stats[core_id].migrations_in.fetch_add(1, std::memory_order_relaxed);
+        }
+        p->last_core = core_id;
+
+        auto dispatch_time = std::chrono::steady_clock::now();
+        p->wait_time += dispatch_time - p->ready_since;
+        if (!p->dispatched) {
+            p->dispatched = true;
+            p->first_dispatch = dispatch_time;
+        }
+        
+        bool process_finished = false;
+        bool process_sleeping = false;
+        bool process_yielded = false;   // SLEEP(0): give up the core but stay ready
+        
+        // get quantum
+        int quantum = (config.scheduler == "rr") ? config.quantum_cycles : 1000;
+        bool adaptive = config.adaptive_quantum && config.scheduler == "rr";
+        QuantumTuner& tuner = tuners[(size_t)(p->sleep_score >= 2 ? ProcClass::SLEEPER : ProcClass::CPU_BOUND)];
+        if (adaptive) {
+            quantum = tuner.quantum.load(std::memory_order_relaxed);
+        }
+
+        int i = 0;
+        for (; i < quantum; ++i) {
+            if (config.delay_per_exec > 0) {
+                // simulate delay
+                std::this_thread::sleep_for(std::chrono::milliseconds(config.delay_per_exec));
+            }
+
+            // summarized loop at the start of a repeat: run as many whole repeats as fit in the
+            // rest of the quantum at once, charging the cycles stepping them would have taken
+            if (!p->loop_stack.empty()) {
+                auto& loop = p->loop_stack.back();
+                const LoopSummary* sum = loop.for_instr->summary.get();
+                if (sum != nullptr && loop.body_pc == 0) {
+                    uint64_t k = std::min<uint64_t>(loop.repeats_left, (uint64_t)(quantum - i) / sum->cycles_per_repeat);
+                    if (k > 0) {
+                        apply_loop_summary(*p, *sum, k);
+                        loop.repeats_left -= (uint32_t)k;
+                        if (loop.repeats_left == 0) {
+                            p->loop_stack.pop_back();
+                        }
+                        uint64_t charged = k * sum->cycles_per_repeat;
+                        if (config.delay_per_exec > 0 && charged > 1) {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(config.delay_per_exec * (long long)(charged - 1)));
+                        }
+                        i += (int)(charged - 1);
+                        continue;
+                    }
+                }
+            }
+
+            // get instruction
+            const Instruction* instr_to_exec = nullptr;
+
+            if (!p->loop_stack.empty()) {
+                // for loop (innermost frame first)
+                auto& loop = p->loop_stack.back();
+                const Instruction& for_instr = *loop.for_instr;
+                if (loop.body_pc >= for_instr.body.size()) {
+                    loop.repeats_left--;
+                    loop.body_pc = 0;
+                    if (loop.repeats_left == 0) {
+                        p->loop_stack.pop_back();
+                    }
+                    continue; 
+                }
+                instr_to_exec = &for_instr.body[loop.body_pc];
+                loop.body_pc++;
+            } else {
+                if (p->pc >= p->program->size()) {
+                    process_finished = true;
+                    break;
+                }
+                
+                instr_to_exec = &(*p->program)[p->pc];
+                p->pc++;
+            }
+
+            if (instr_to_exec->type == InstrType::FOR_) {
+                if (instr_to_exec->repeats > 0 && !instr_to_exec->body.empty()) {
+                    p->loop_stack.push_back({instr_to_exec, 0, instr_to_exec->repeats});
+                }
+                continue; 
+            }
+
+            if (process_finished) break;
+
+            // execute instruction
+            ExecStatus status = execute_instruction(*p, *instr_to_exec);
+            if (status == ExecStatus::SLEEP) {
+                // the clock only wakes processes with ticks left, so a zero-tick sleep is a yield
+                if (p->sleep_left == 0) {
+                    process_yielded = true;
+                } else {
+                    process_sleeping = true;
+                }
+                break;
+            }
+        }
+
+        // cycles used this quantum; the SLEEP that ended it counts as executed
+        auto quantum_end = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration requeue_wait{0};
+        uint64_t cycles = (uint64_t)(process_sleeping || process_yielded ? i + 1 : i);
+        uint64_t useful = ns(quantum_end - dispatch_time);
+        cs.instructions.fetch_add(cycles, std::memory_order_relaxed);
+        cs.busy_ns.fetch_add(useful, std::memory_order_relaxed);
+        cs.current_pid.store(-1, std::memory_order_relaxed);
+
+        if (process_sleeping) {
+            if (p->sleep_score < 3) p->sleep_score++;
+        } else if (p->sleep_score > 0) {
+            p->sleep_score--;
+        }
+
+        if (process_finished) {
+            p->running = false;
+            p->finished = true;
+            p->finish_time = std::chrono::steady_clock::now();
+            tracer.event(TraceEvt::FINISH, core_id, p->pid);
+            record_finished(*p);
+            finished_count.fetch_add(1, std::memory_order_relaxed);
+        } 
+        else if (process_sleeping) {
+            // running stays true if process is sleeping
+            sleeping_count.fetch_add(1, std::memory_order_relaxed);
+            tracer.event(TraceEvt::SLEEP, core_id, p->pid);
+        } 
+        else {
+            // quantum expired (or SLEEP(0) yielded), put back in ready queue
+            p->running = false;
+            p->ready_since = std::chrono::steady_clock::now();
+            tracer.event(TraceEvt::PREEMPT, core_id, p->pid);
+            auto wait_start = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lk_ready(ready_queue_mtx);
+            requeue_wait = std::chrono::steady_clock::now() - wait_start;
+            enqueue_ready_locked(p->pid, core_id);
+        }
+
+        // switch overhead: dequeue, process table scan and whatever followed the quantum,
+        // less the wait for ready_queue_mtx when requeuing
+        uint64_t overhead = ns(picked - pick_start) + ns(dispatch_time - scan_start) +
+                            ns(std::chrono::steady_clock::now() - quantum_end - requeue_wait);
+        cs.overhead_ns.fetch_add(overhead, std::memory_order_relaxed);
+        if (adaptive) {
+            tuner.overhead_ns.fetch_add(overhead, std::memory_order_relaxed);
+            tuner.useful_ns.fetch_add(useful, std::memory_order_relaxed);
+            tuner.cycles.fetch_add(cycles, std::memory_order_relaxed);
+            tuner.dispatches.fetch_add(1, std::memory_order_relaxed);
+            if (!process_finished && !process_sleeping && !process_yielded) tuner.expired.fetch_add(1, std::memory_order_relaxed);
+            tuner.total_overhead_ns.fetch_add(overhead, std::memory_order_relaxed);
+            tuner.total_useful_ns.fetch_add(useful, std::memory_order_relaxed);
+            tuner.total_cycles.fetch_add(cycles, std::memory_order_relaxed);
+            tuner.total_dispatches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Move a class's quantum toward the one that would make switch overhead target_overhead percent
+// of core time. With O ns of overhead per dispatch and u ns of useful work per cycle,
+// O / (O + q*u) = t gives q = O(1-t) / (t*u). A class that mostly sleeps before its quantum runs
+// out gains nothing from a longer one, so it is held near the cycles it actually uses. Each
+// retune goes halfway to damp noise; classes with too few dispatches in the window keep theirs.
+void Emulator::retune_quantum(QuantumTuner& t) {
+    if (t.dispatches.load(std::memory_order_relaxed) < 8) return;
+
+    uint64_t d = t.dispatches.exchange(0);
+    uint64_t e = t.expired.exchange(0);
+    uint64_t o = t.overhead_ns.exchange(0);
+    uint64_t u = t.useful_ns.exchange(0);
+    uint64_t c = t.cycles.exchange(0);
+    if (d == 0 || c == 0 || u == 0) return;
+
+    double target = config.target_overhead / 100.0;
+    double want = ((double)o / d) * (1.0 - target) / (target * ((double)u / c));
+    if (e * 2 < d) {
+        want = std::min(want, 2.0 * c / d);
+    }
+
+    int lo = std::max(1, config.quantum_min);
+    int hi = std::max(lo, config.quantum_max);
+    double next = (t.quantum.load() + want) / 2.0;
+    t.quantum = (int)std::max<double>(lo, std::min<double>(hi, std::round(next)));
+}
+
+// Publish the processes the live view lists: running first, then sleeping, then ready, at most
+// kProcessRows of them; processes_mtx must be held
+void Emulator::publish_process_rows_locked() {
+    auto rank = [](const PseudoProcess& p) { return !p.running ? 2 : (p.sleep_left > 0 ? 1 : 0); };
+
+    std::vector<const PseudoProcess*> live;
+    for (const auto& p : processes) {
+        if (!p.finished) live.push_back(&p);
+    }
+    size_t n = std::min(live.size(), kProcessRows);
+    std::partial_sort(live.begin(), live.begin() + n, live.end(), [&](const PseudoProcess* a, const PseudoProcess* b) {
+        int ra = rank(*a), rb = rank(*b);
+        return ra != rb ? ra < rb : a->pid < b->pid;
+    });
+
+    static const char* const state_names[] = {"RUNNING", "SLEEPING", "READY"};
+    auto rows = std::make_shared<std::vector<ProcessRow>>();
+    rows->reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const PseudoProcess& p = *live[i];
+        rows->push_back({p.pid, p.name, state_names[rank(p)], p.last_core, p.pc, p.program->size(), uptime_ms(p)});
+    }
+    std::atomic_store(&published_rows, ProcessRowsPtr(std::move(rows)));
+}
+
+// Clock thread
+void Emulator::clock_thread() {
+    while (running) {
+        {
+            cpu_cycles++; // system clock tick
+
+            std::vector<std::pair<int, int>> pids_to_ready; // pid, last core
+
+            // check sleeping processes
+            {
+                std::lock_guard<std::mutex> lk(processes_mtx);
+                for (auto& p : processes) {
+                    // if sleeping (running and sleep_left > 0)
+                    if (p.running && p.sleep_left > 0) {
+                        p.sleep_left--;
+                        if (p.sleep_left == 0) {
+                            // process is done sleeping, mark it as ready
+                            p.running = false; 
+                            p.ready_since = std::chrono::steady_clock::now();
+                            pids_to_ready.push_back({p.pid, p.last_core});
+                            sleeping_count.fetch_sub(1, std::memory_order_relaxed);
+                            tracer.event(TraceEvt::WAKE, -1, p.pid);
+                        }
+                    }
+                }
+                if (process_rows_watchers.load(std::memory_order_relaxed) > 0) {
+                    publish_process_rows_locked();
+                }
+            } 
+
+            // add new process to ready queue
+            if (!pids_to_ready.empty()) {
+                std::lock_guard<std::mutex> lk(ready_queue_mtx);
+                for (const auto& pr : pids_to_ready) {
+                    enqueue_ready_locked(pr.first, pr.second);
+                }
+            }
+
+        }
+
+        if (config.adaptive_quantum && config.scheduler == "rr") {
+            for (auto& t : tuners) retune_quantum(t);
+        }
+
+        // sleep
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.tick_ms));
+    }
+}
+
+std::string MetricsServer::metrics_text() {
+    CounterSnapshot cur = emu.snapshot();
+
+    // rates come from the last complete window (zero until the first one closes)
+    CounterSnapshot prev, end;
+    {
+        std::lock_guard<std::mutex> lk(window_mtx);
+        prev = window_start;
+        end = window_end;
+    }
+    double secs = std::chrono::duration<double>(end.taken - prev.taken).count();
+
+    std::ostringstream out;
+    auto metric = [&](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+
+    metric("csopesy_ticks_total", "counter", "CPU ticks since the emulator started.");
+    out << "csopesy_ticks_total " << cur.ticks << '\n';
+
+    metric("csopesy_ready_queue_depth", "gauge", "Processes waiting in the ready queues.");
+    out << "csopesy_ready_queue_depth " << cur.ready << '\n';
+
+    metric("csopesy_processes", "gauge", "Processes by state.");
+    out << "csopesy_processes{state=\"ready\"} " << cur.ready << '\n';
+    out << "csopesy_processes{state=\"running\"} " << cur.running << '\n';
+    out << "csopesy_processes{state=\"sleeping\"} " << cur.sleeping << '\n';
+    out << "csopesy_processes{state=\"finished\"} " << cur.finished << '\n';
+
+    metric("csopesy_processes_created_total", "counter", "Processes created.");
+    out << "csopesy_processes_created_total " << cur.created << '\n';
+
+    metric("csopesy_scheduler_generating", "gauge", "1 while the batch process generator is running.");
+    out << "csopesy_scheduler_generating " << (cur.generating ? 1 : 0) << '\n';
+
+    metric("csopesy_instructions_total", "counter", "Instruction cycles executed by all cores.");
+    out << "csopesy_instructions_total " << cur.instructions << '\n';
+
+    metric("csopesy_instructions_per_second", "gauge", "Instruction cycles per second over the last second.");
+    out << "csopesy_instructions_per_second "
+        << (secs > 0 ? (uint64_t)((end.instructions - prev.instructions) / secs) : 0) << '\n';
+
+    metric("csopesy_rr_quantum", "gauge", "Round-robin quantum in cycles per process class; quantum-cycles unless adaptive-quantum is on.");
+    for (size_t c = 0; c < NUM_PROC_CLASSES; ++c) {
+        out << "csopesy_rr_quantum{class=\"" << proc_class_names[c] << "\"} " << cur.quantum[c] << '\n';
+    }
+
+    metric("csopesy_core_utilization", "gauge", "Share of host time each core spent running quanta over the last second.");
+    for (size_t i = 0; i < end.cores.size(); ++i) {
+        uint64_t prev_busy = i < prev.cores.size() ? prev.cores[i].busy_ns : 0;
+        double util = secs > 0 ? (end.cores[i].busy_ns - prev_busy) / (secs * 1e9) : 0.0;
+        out << "csopesy_core_utilization{core=\"" << i << "\"} " << std::min(1.0, util) << '\n';
+    }
+
+    metric("csopesy_core_busy_seconds_total", "counter", "Host time each core spent running quanta.");
+    for (size_t i = 0; i < cur.cores.size(); ++i) {
+        out << "csopesy_core_busy_seconds_total{core=\"" << i << "\"} " << cur.cores[i].busy_ns / 1e9 << '\n';
+    }
+
+    metric("csopesy_core_dispatches_total", "counter", "Processes dispatched on each core.");
+    for (size_t i = 0; i < cur.cores.size(); ++i) {
+        out << "csopesy_core_dispatches_total{core=\"" << i << "\"} " << cur.cores[i].dispatches << '\n';
+    }
+
+    metric("csopesy_core_migrations_total", "counter", "Dispatches of a process that last ran on another core.");
+    for (size_t i = 0; i < cur.cores.size(); ++i) {
+        out << "csopesy_core_migrations_total{core=\"" << i << "\"} " << cur.cores[i].migrations_in << '\n';
+    }
+
+    return out.str();
+}
+
+#ifdef __linux__
+
+bool MetricsServer::start(const std::string& socket_path, std::string& error) {
+    if (on) {
+        error = "metrics server already running on '" + path + "'";
+        return false;
+    }
+
+    sockaddr_un addr{};
+    if (socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path)) {
+        error = "metrics socket path must be 1 to " + std::to_string(sizeof(addr.sun_path) - 1) + " characters";
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    // a socket left behind by an earlier run would make bind fail; never remove anything else
+    struct stat st;
+    if (lstat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(socket_path.c_str());
+    }
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0) {
+        error = "cannot listen on '" + socket_path + "': " + std::strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd;
+    bool ok = epoll_fd >= 0 && wake_fd >= 0 && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) == 0;
+    ev.data.fd = wake_fd;
+    ok = ok && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev) == 0;
+    if (!ok) {
+        error = std::string("epoll: ") + std::strerror(errno);
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (wake_fd >= 0) close(wake_fd);
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        epoll_fd = wake_fd = listen_fd = -1;
+        return false;
+    }
+
+    path = socket_path;
+    window_end = emu.snapshot();
+    window_start = window_end;
+    on = true;
+    worker = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!on.exchange(false)) return;
+
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // the eventfd cannot be full here; serve() also checks 'on' after every wakeup
+    }
+    if (worker.joinable()) worker.join();
+
+    for (auto& kv : clients) close(kv.first);
+    clients.clear();
+    close(listen_fd);
+    close(epoll_fd);
+    close(wake_fd);
+    listen_fd = epoll_fd = wake_fd = -1;
+    unlink(path.c_str());
+}
+
+void MetricsServer::serve() {
+    epoll_event events[32];
+
+    while (on) {
+        advance_window();
+        auto until_next = window_end.taken + kRateWindow - std::chrono::steady_clock::now();
+        int timeout_ms = (int)std::max<long long>(
+            1, std::chrono::duration_cast<std::chrono::milliseconds>(until_next).count() + 1);
+
+        int n = epoll_wait(epoll_fd, events, 32, timeout_ms);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int e = 0; e < n && on; ++e) {
+            int fd = events[e].data.fd;
+
+            if (fd == wake_fd) {
+                continue;
+            }
+
+            if (fd == listen_fd) {
+                // accept every pending connection
+                for (;;) {
+                    int cfd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (cfd < 0) break;
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = cfd;
+                    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, cfd, &ev) < 0) {
+                        close(cfd);
+                        continue;
+                    }
+                    clients[cfd] = Client();
+                }
+                continue;
+            }
+
+            auto it = clients.find(fd);
+            if (it == clients.end()) continue;
+
+            if (events[e].events & EPOLLERR) {
+                close_client(fd);
+                continue;
+            }
+            if (events[e].events & (EPOLLIN | EPOLLHUP)) {
+                handle_input(fd, it->second);
+                it = clients.find(fd);
+                if (it == clients.end()) continue;
+            }
+            if (!flush(fd, it->second)) {
+                close_client(fd);
+            }
+        }
+    }
+}
+
+// Close the rate window once it is kRateWindow old; called from the server thread only
+void MetricsServer::advance_window() {
+    if (std::chrono::steady_clock::now() - window_end.taken < kRateWindow) return;
+    CounterSnapshot snap = emu.snapshot();
+    std::lock_guard<std::mutex> lk(window_mtx);
+    window_start = std::move(window_end);
+    window_end = std::move(snap);
+}
+
+// Read what the client sent and queue the replies for every complete request
+void MetricsServer::handle_input(int fd, Client& c) {
+    char buf[1024];
+    bool eof = false; // the client closed its side (or the read failed)
+    for (;;) {
+        ssize_t r = read(fd, buf, sizeof(buf));
+        if (r > 0) {
+            c.in.append(buf, (size_t)r);
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        eof = true;
+        break;
+    }
+
+    // HTTP scrape: wait for the end of the headers, answer and close
+    if (c.in.compare(0, 4, "GET ") == 0) {
+        if (c.in.find("\r\n\r\n") == std::string::npos && c.in.find("\n\n") == std::string::npos) {
+            if (eof || c.in.size() > 8192) close_client(fd);
+            return;
+        }
+        std::string target = c.in.substr(4, c.in.find(' ', 4) - 4);
+        std::string body, status;
+        if (target == "/metrics") {
+            status = "200 OK";
+            body = metrics_text();
+        } else {
+            status = "404 Not Found";
+            body = "Only /metrics is served here.\n";
+        }
+        c.out += "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                 std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        c.in.clear();
+        c.close_after_write = true;
+        return;
+    }
+
+    // line protocol; a last line without a newline still counts once the client closes its side
+    if (eof && !c.in.empty() && c.in.back() != '\n') c.in += '\n';
+    size_t nl;
+    while (!c.close_after_write && (nl = c.in.find('\n')) != std::string::npos) {
+        std::string line = c.in.substr(0, nl);
+        c.in.erase(0, nl + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        c.out += run_command(line, c.close_after_write);
+    }
+    if (eof) {
+        c.close_after_write = true;
+    } else if (c.in.size() > 8192) {
+        close_client(fd);
+    }
+}
+
+std::string MetricsServer::run_command(const std::string& line, bool& close_after) {
+    if (line == "metrics") {
+        return metrics_text() + "# EOF\n";
+    }
+    if (line == "scheduler-start") {
+        std::string error;
+        return emu.try_start_generator(error) ? "ok: Scheduler started.\n" : "error: " + error + "\n";
+    }
+    if (line == "scheduler-stop") {
+        return emu.request_generator_stop() ? "ok: Scheduler stopping.\n" : "error: Scheduler is not running.\n";
+    }
+    if (line == "quit") {
+        close_after = true;
+        return "";
+    }
+    return "error: unknown command '" + line + "'. Commands are metrics, scheduler-start, scheduler-stop, quit.\n";
+}
+
+// Write as much pending output as the socket takes; watch for EPOLLOUT only while some is left
+bool MetricsServer::flush(int fd, Client& c) {
+    while (!c.out.empty()) {
+        ssize_t w = send(fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (w > 0) {
+            c.out.erase(0, (size_t)w);
+            continue;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+
+    if (c.out.empty() && c.close_after_write) return false;
+
+    epoll_event ev{};
+    ev.events = c.out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    return true;
+}
+
+void MetricsServer::close_client(int fd) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients.erase(fd);
+}
 
-        case InstrType::FOR_:
-            // handled by core function
-            break;
+#else
+
+bool MetricsServer::start(const std::string& socket_path, std::string& error) {
+    (void)socket_path;
+    error = "the metrics server is only supported on Linux";
+    return false;
+}
+
+void MetricsServer::stop() {}
+
+#endif
+
+// Apply one "key value" setting from config.txt; throws std::exception on a malformed number
+static bool apply_config_value(Config& cfg, const std::string& key, std::string value_str) {
+    if (key == "num-cpu") {
+        cfg.num_cpu = std::stoi(value_str);
+    } else if (key == "scheduler") {
+        // remove quotes from "rr" or "fcfs"
+        if (!value_str.empty() && value_str.front() == '"') value_str.erase(0, 1);
+        if (!value_str.empty() && value_str.back() == '"') value_str.pop_back();
+        cfg.scheduler = value_str;
+    } else if (key == "quantum-cycles") {
+        cfg.quantum_cycles = std::stoi(value_str);
+    } else if (key == "batch-process-freq") {
+        cfg.batch_process_freq = std::stol(value_str);
+    } else if (key == "min-ins") {
+        cfg.min_ins = std::stol(value_str);
+    } else if (key == "max-ins") {
+        cfg.max_ins = std::stol(value_str);
+    } else if (key == "delay-per-exec") {
+        cfg.delay_per_exec = std::stol(value_str);
+    } else if (key == "pin-cores") {
+        cfg.pin_cores = std::stoi(value_str) != 0;
+    } else if (key == "soft-affinity") {
+        cfg.soft_affinity = std::stoi(value_str) != 0;
+    } else if (key == "affinity-slack") {
+        cfg.affinity_slack = std::max(0, std::stoi(value_str));
+    } else if (key == "optimize-programs") {
+        cfg.optimize_programs = std::stoi(value_str) != 0;
+    } else if (key == "tick-ms") {
+        cfg.tick_ms = std::max(1, std::stoi(value_str));
+    } else if (key == "adaptive-quantum") {
+        cfg.adaptive_quantum = std::stoi(value_str) != 0;
+    } else if (key == "quantum-min") {
+        cfg.quantum_min = std::max(1, std::stoi(value_str));
+    } else if (key == "quantum-max") {
+        cfg.quantum_max = std::max(1, std::stoi(value_str));
+    } else if (key == "target-overhead") {
+        cfg.target_overhead = std::max(0.1, std::min(90.0, std::stod(value_str)));
+    } else if (key == "dashboard-fps") {
+        cfg.dashboard_fps = std::max(1, std::min(60, std::stoi(value_str)));
+    } else if (key == "metrics-socket") {
+        if (!value_str.empty() && value_str.front() == '"') value_str.erase(0, 1);
+        if (!value_str.empty() && value_str.back() == '"') value_str.pop_back();
+        cfg.metrics_socket = value_str;
+    } else {
+        return false;
     }
-    return ExecStatus::OK;
+    return true;
 }
 
-// CPU thread function
-void cpu_core_function(int core_id) {
-    while (is_running) {
-        // get process id from ready queue
-        int pid_to_run = -1;
-        {
-            std::lock_guard<std::mutex> lk(g_ready_queue_mtx);
-            if (!g_ready_queue.empty()) {
-                pid_to_run = g_ready_queue.front();
-                g_ready_queue.pop();
-            }
-        }
+// Load config.txt into 'cfg'; false if the file cannot be opened
+static bool load_config(const std::string& path, Config& cfg) {
+    std::ifstream config_file(path);
+    if (!config_file.is_open()) {
+        return false;
+    }
 
-        if (pid_to_run == -1) {
-            // if no work to do, sleep and try again
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::string line;
+    std::string key;
+    std::string value_str;
+
+    while (std::getline(config_file, line)) {
+        std::istringstream iss(line);
+        if (!(iss >> key >> value_str)) {
+            // skip whitespace
             continue;
         }
-        
-        std::lock_guard<std::mutex> lk(g_processes_mtx);
-        
-        // find process
-        PseudoProcess* p = nullptr;
-        for (auto& proc : g_processes) {
-            if (proc.pid == pid_to_run) {
-                p = &proc;
-                break;
-            }
+
+        try {
+            apply_config_value(cfg, key, value_str);
+        } catch (const std::exception& e) {
+            cout << "Error parsing config line: " << line << "\n";
         }
+    }
+    config_file.close();
+    return true;
+}
 
-        // if process not found or already running/finished, skip
-        if (p == nullptr || p->finished || p->running) {
-            continue;
+// Report Utilization
+// If out_file is non-empty, the same report is also saved to that file (overwrites existing file).
+void report_utilization(Emulator& emu, const std::string& out_file = "") {
+    std::string report = emu.utilization_report();
+
+    // Print to console
+    std::cout << report;
+
+    // Optionally save to file (overwrite)
+    if (!out_file.empty()) {
+        std::ofstream ofs(out_file, std::ios::out | std::ios::trunc);
+        if (ofs.is_open()) {
+            ofs << report;
+            ofs.close();
+            std::cout << "Saved report to '" << out_file << "'.\n";
+        } else {
+            std::cout << "Error: could not open file '" << out_file << "' for writing.\n";
         }
+    }
+}
 
-        p->running = true;
-        
-        bool process_finished = false;
-        bool process_sleeping = false;
-        
-        // get quantum
-        int quantum = (g_config.scheduler == "rr") ? g_config.quantum_cycles : 1000;
+// Send a whole frame to the terminal with a single write, bypassing the stream buffers
+static void write_frame(const std::string& frame) {
+    std::cout.flush();
+#ifdef _WIN32
+    std::fwrite(frame.data(), 1, frame.size(), stdout);
+    std::fflush(stdout);
+#else
+    std::fflush(stdout);
+    size_t off = 0;
+    while (off < frame.size()) {
+        ssize_t w = ::write(STDOUT_FILENO, frame.data() + off, frame.size() - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        off += (size_t)w;
+    }
+#endif
+}
 
-        for (int i = 0; i < quantum; ++i) {
-            if (g_config.delay_per_exec > 0) {
-                // simulate delay
-                std::this_thread::sleep_for(std::chrono::milliseconds(g_config.delay_per_exec));
-            }
+// Live "top"-style view of the emulator. Each frame is drawn into an off-screen buffer and
+// compared with the previous one, so only the changed cells go to the terminal, in one write per
+// frame. Data comes from Emulator::snapshot(), so drawing never takes the emulator's locks.
+class Dashboard {
+public:
+    ~Dashboard() { stop(); }
+
+    void start(Emulator& emu);   // clear the screen and draw at the configured frame rate
+    void stop();                 // stop drawing and clear the screen
+    bool active() const { return on.load(); }
+
+private:
+    void run(Emulator* emu);
+    void render(const Emulator& emu, const CounterSnapshot& cur, const CounterSnapshot& prev);
+    void put(size_t row, const std::string& text);
+    std::string diff_frame();
+
+    std::vector<std::string> front;  // what the terminal shows
+    std::vector<std::string> back;   // the frame being drawn
+    std::atomic<bool> on{false};
+    std::thread worker;
+};
 
-            // get instruction
-            Instruction* instr_to_exec = nullptr;
+Dashboard g_dashboard;
 
-            if (!p->loop_stack.empty()) {
-                // for loop
-                auto& loop = p->loop_stack.back();
-                Instruction& for_instr = p->program[loop.for_instr_pc];
-                if (loop.body_pc >= for_instr.body.size()) {
-                    loop.repeats_left--;
-                    loop.body_pc = 0;
-                    if (loop.repeats_left == 0) {
-                        p->loop_stack.pop_back();
-                        p->pc = loop.for_instr_pc + 1;
-                    }
-                    continue; 
-                }
-                instr_to_exec = &for_instr.body[loop.body_pc];
-                loop.body_pc++;
-            } else {
-                if (p->pc >= p->program.size()) {
-                    process_finished = true;
-                    break;
-                }
-                
-                instr_to_exec = &p->program[p->pc];
+void Dashboard::start(Emulator& emu) {
+    if (on.exchange(true)) return;
+    worker = std::thread(&Dashboard::run, this, &emu);
+}
 
-                if (instr_to_exec->type == InstrType::FOR_) {
-                    if (instr_to_exec->repeats > 0) {
-                        p->loop_stack.push_back({p->pc, 0, instr_to_exec->repeats});
-                    }
-                    p->pc++;
-                    continue; 
-                }
-                
-                p->pc++;
-            }
+void Dashboard::stop() {
+    if (!on.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+    write_frame("\033[?25h\033[2J\033[H");
+}
 
-            if (process_finished) break;
+void Dashboard::run(Emulator* emu) {
+    size_t width = display_width;
+    size_t height = 10 + (size_t)std::max(0, emu->config.num_cpu) + Emulator::kProcessRows;
+    front.assign(height, std::string(width, ' '));
+    back = front;
+    write_frame("\033[?25l\033[2J"); // hide the cursor and start from a blank screen
+    emu->process_rows_watchers++;
+
+    auto period = std::chrono::microseconds(1000000 / emu->config.dashboard_fps);
+    auto next_frame = std::chrono::steady_clock::now();
+    CounterSnapshot prev = emu->snapshot();
+
+    while (on) {
+        next_frame += period;
+        std::this_thread::sleep_until(next_frame);
+
+        CounterSnapshot cur = emu->snapshot();
+        render(*emu, cur, prev);
+        std::string frame = diff_frame();
+        if (!frame.empty()) write_frame(frame);
+        prev = std::move(cur);
+    }
+    emu->process_rows_watchers--;
+}
 
-            // execute instruction
-            ExecStatus status = execute_instruction(*p, *instr_to_exec);
-            if (status == ExecStatus::SLEEP) {
-                process_sleeping = true;
-                break;
-            }
+// Write 'text' into a row of the back buffer, padded or cut to the screen width
+void Dashboard::put(size_t row, const std::string& text) {
+    if (row >= back.size()) return;
+    std::string& line = back[row];
+    size_t n = std::min(text.size(), line.size());
+    line.replace(0, n, text, 0, n);
+    std::fill(line.begin() + n, line.end(), ' ');
+}
+
+void Dashboard::render(const Emulator& emu, const CounterSnapshot& cur, const CounterSnapshot& prev) {
+    double secs = std::chrono::duration<double>(cur.taken - prev.taken).count();
+    long long up = (long long)std::chrono::duration<double>(cur.taken - emu.started_at).count();
+    char buf[256];
+    size_t row = 0;
+
+    std::snprintf(buf, sizeof(buf), "CSOPESY top - up %02lld:%02lld:%02lld, tick %d, scheduler %s, generator %s, %d fps",
+                  up / 3600, up / 60 % 60, up % 60, cur.ticks, emu.config.scheduler.c_str(),
+                  cur.generating ? "on" : "off", emu.config.dashboard_fps);
+    put(row++, buf);
+
+    std::snprintf(buf, sizeof(buf), "Processes: %llu created, %lld ready, %d running, %lld sleeping, %llu finished",
+                  (unsigned long long)cur.created, (long long)cur.ready, cur.running, (long long)cur.sleeping,
+                  (unsigned long long)cur.finished);
+    put(row++, buf);
+
+    uint64_t rate = secs > 0 ? (uint64_t)((cur.instructions - prev.instructions) / secs) : 0;
+    if (emu.config.adaptive_quantum && emu.config.scheduler == "rr") {
+        std::snprintf(buf, sizeof(buf), "Throughput: %llu cycles/s, quantum %s %d, %s %d", (unsigned long long)rate,
+                      proc_class_names[0], cur.quantum[0], proc_class_names[1], cur.quantum[1]);
+    } else {
+        std::snprintf(buf, sizeof(buf), "Throughput: %llu cycles/s", (unsigned long long)rate);
+    }
+    put(row++, buf);
+    put(row++, "");
+
+    put(row++, "CORE  PID       UTIL%    CYCLES/S  DISPATCHES  MIGRATIONS");
+    for (size_t i = 0; i < cur.cores.size(); ++i) {
+        const CounterSnapshot::Core& c = cur.cores[i];
+        uint64_t prev_busy = i < prev.cores.size() ? prev.cores[i].busy_ns : 0;
+        uint64_t prev_instr = i < prev.cores.size() ? prev.cores[i].instructions : 0;
+        double util = secs > 0 ? std::min(100.0, (c.busy_ns - prev_busy) / (secs * 1e7)) : 0.0;
+        std::string pid = c.busy ? std::to_string(c.pid) : "-";
+        std::snprintf(buf, sizeof(buf), "%-4zu  %-8s  %5.1f  %10llu  %10llu  %10llu", i, pid.c_str(), util,
+                      (unsigned long long)(secs > 0 ? (c.instructions - prev_instr) / secs : 0),
+                      (unsigned long long)c.dispatches, (unsigned long long)c.migrations_in);
+        put(row++, buf);
+    }
+    put(row++, "");
+
+    // process list, as last published by the clock
+    ProcessRowsPtr procs = emu.process_rows();
+    put(row++, "PID       NAME                  STATE     CORE  LINE           UPTIME(s)");
+    for (size_t i = 0; i < Emulator::kProcessRows; ++i) {
+        if (procs == nullptr || i >= procs->size()) {
+            put(row++, "");
+            continue;
         }
+        const ProcessRow& p = (*procs)[i];
+        std::string core = p.last_core >= 0 ? std::to_string(p.last_core) : "-";
+        std::string line = std::to_string(p.line) + "/" + std::to_string(p.lines);
+        std::snprintf(buf, sizeof(buf), "%-8d  %-20.20s  %-8s  %-4s  %-13s  %9.1f", p.pid, p.name.c_str(), p.state,
+                      core.c_str(), line.c_str(), p.uptime_ms / 1000.0);
+        put(row++, buf);
+    }
+    put(row++, "");
+    put(row++, "Press q to return to the console.");
+}
 
-        if (process_finished) {
-            p->running = false;
-            p->finished = true;
-        } 
-        else if (process_sleeping) {
-            // running stays true if process is sleeping
-        } 
-        else {
-            // quantum expired, put back in ready queue
-            p->running = false;
-            std::lock_guard<std::mutex> lk_ready(g_ready_queue_mtx);
-            g_ready_queue.push(p->pid);
+// Cursor moves and text for every run of cells that changed since the last frame. Runs closer
+// than a cursor move are merged, since rewriting a few unchanged cells is cheaper.
+std::string Dashboard::diff_frame() {
+    const size_t merge_gap = 8;
+    std::string out;
+
+    for (size_t r = 0; r < back.size(); ++r) {
+        const std::string& now = back[r];
+        std::string& shown = front[r];
+        size_t c = 0;
+        while (c < now.size()) {
+            if (now[c] == shown[c]) {
+                ++c;
+                continue;
+            }
+            size_t start = c;
+            size_t end = c + 1; // one past the last changed cell of the run
+            for (size_t k = end; k < now.size() && k < end + merge_gap; ++k) {
+                if (now[k] != shown[k]) end = k + 1;
+            }
+            out += "\033[" + std::to_string(r + 1) + ";" + std::to_string(start + 1) + "H";
+            out.append(now, start, end - start);
+            shown.replace(start, end - start, now, start, end - start);
+            c = end;
         }
     }
+    return out;
 }
 
 // Command interpreter
-void command_interpreter_thread(string input) {
+void command_interpreter_thread(string input, std::unique_ptr<Emulator>& emu) {
     vector<string> tokens = tokenize_input(input);
     if (tokens.empty()) return;
 
@@ -495,9 +2562,9 @@ void command_interpreter_thread(string input) {
             cout << "Returned to main console.\n";
         } 
         else if (cmd == "process-smi") {
-            std::lock_guard<std::mutex> lk(g_processes_mtx);
+            std::lock_guard<std::mutex> lk(emu->processes_mtx);
             PseudoProcess* p_ptr = nullptr;
-            for(auto& p : g_processes) {
+            for(auto& p : emu->processes) {
                 if(p.pid == attached_pid) {
                     p_ptr = &p;
                     break;
@@ -523,7 +2590,7 @@ void command_interpreter_thread(string input) {
             }
             
             cout << "Current instruction line: " << p_ptr->pc << "\n";
-            cout << "Total lines of code: " << p_ptr->program.size() << "\n";
+            cout << "Total lines of code: " << p_ptr->program->size() << "\n";
 
             if (p_ptr->finished) {
                 cout << "Finished!\n";
@@ -549,77 +2616,64 @@ void command_interpreter_thread(string input) {
 
     // initialize before anything else
     if (cmd == "initialize") {
-        if (is_initialized) {
+        if (emu) {
             cout << "Already initialized.\n";
             return;
         }
 
-        std::ifstream config_file("config.txt");
-        if (!config_file.is_open()) {
+        Config cfg;
+        if (!load_config("config.txt", cfg)) {
             cout << "Error: config.txt not found. Cannot initialize.\n";
             return;
         }
 
-        std::string line;
-        std::string key;
-        std::string value_str;
-
-        while (std::getline(config_file, line)) {
-            std::istringstream iss(line);
-            if (!(iss >> key >> value_str)) {
-                // skip whitespace
-                continue;
-            }
-
-            try {
-                if (key == "num-cpu") {
-                    g_config.num_cpu = std::stoi(value_str);
-                } else if (key == "scheduler") {
-                    // remove quotes from "rr" or "fcfs"
-                    if (value_str.front() == '"') value_str.erase(0, 1);
-                    if (value_str.back() == '"') value_str.pop_back();
-                    g_config.scheduler = value_str;
-                } else if (key == "quantum-cycles") {
-                    g_config.quantum_cycles = std::stoi(value_str);
-                } else if (key == "batch-process-freq") {
-                    g_config.batch_process_freq = std::stol(value_str);
-                } else if (key == "min-ins") {
-                    g_config.min_ins = std::stol(value_str);
-                } else if (key == "max-ins") {
-                    g_config.max_ins = std::stol(value_str);
-                } else if (key == "delay-per-exec") {
-                    g_config.delay_per_exec = std::stol(value_str);
-                }
-            } catch (const std::exception& e) {
-                cout << "Error parsing config line: " << line << "\n";
-            }
-        }
-        config_file.close();
-
-        is_initialized = true;
         cout << "System initialized.\n";
 
         // show configuration summary
-        cout << "  - num-cpu: " << g_config.num_cpu << "\n";
-        cout << "  - scheduler: " << g_config.scheduler << "\n";
-        cout << "  - quantum-cycles: " << g_config.quantum_cycles << "\n";
-        cout << "  - batch-process-freq: " << g_config.batch_process_freq << "\n";
-        cout << "  - min-ins: " << g_config.min_ins << "\n";
-        cout << "  - max-ins: " << g_config.max_ins << "\n";
-        cout << "  - delay-per-exec: " << g_config.delay_per_exec << "\n";
+        cout << "  - num-cpu: " << cfg.num_cpu << "\n";
+        cout << "  - scheduler: " << cfg.scheduler << "\n";
+        cout << "  - quantum-cycles: " << cfg.quantum_cycles << "\n";
+        cout << "  - batch-process-freq: " << cfg.batch_process_freq << "\n";
+        cout << "  - min-ins: " << cfg.min_ins << "\n";
+        cout << "  - max-ins: " << cfg.max_ins << "\n";
+        cout << "  - delay-per-exec: " << cfg.delay_per_exec << "\n";
+        cout << "  - pin-cores: " << cfg.pin_cores << "\n";
+        cout << "  - soft-affinity: " << cfg.soft_affinity << "\n";
+        cout << "  - affinity-slack: " << cfg.affinity_slack << "\n";
+        cout << "  - optimize-programs: " << cfg.optimize_programs << "\n";
+        cout << "  - tick-ms: " << cfg.tick_ms << "\n";
+        cout << "  - adaptive-quantum: " << cfg.adaptive_quantum << "\n";
+        if (cfg.adaptive_quantum) {
+            cout << "  - quantum-min: " << cfg.quantum_min << "\n";
+            cout << "  - quantum-max: " << cfg.quantum_max << "\n";
+            cout << "  - target-overhead: " << cfg.target_overhead << "%\n";
+        }
+        cout << "  - dashboard-fps: " << cfg.dashboard_fps << "\n";
+        cout << "  - metrics-socket: " << (cfg.metrics_socket.empty() ? "(off)" : cfg.metrics_socket) << "\n";
+#ifndef __linux__
+        if (cfg.pin_cores) cout << "Warning: pin-cores is only supported on Linux; core threads will not be pinned.\n";
+#endif
         
         // launch cpu threads
-        cout << "Launching " << g_config.num_cpu << " CPU cores...\n";
-        for (int i = 0; i < g_config.num_cpu; ++i) {
-            std::thread(cpu_core_function, i).detach();
-        }
+        cout << "Launching " << cfg.num_cpu << " CPU cores...\n";
+        emu.reset(new Emulator(cfg));
+        emu->start();
         cout << "CPU cores running.\n";
+
+        if (!cfg.metrics_socket.empty()) {
+            std::string error;
+            if (emu->metrics.start(cfg.metrics_socket, error)) {
+                cout << "Metrics server listening on '" << cfg.metrics_socket << "'.\n";
+            } else {
+                cout << "Error: " << error << ".\n";
+            }
+        }
         
         return;
     }
 
     // rejects all other commands if not initialized
-    if (!is_initialized) {
+    if (!emu) {
         cout << "Error: system not initialized. Run \"initialize\" or \"exit\".\n";
         return;
     }
@@ -632,22 +2686,29 @@ void command_interpreter_thread(string input) {
         cout << "\"exit\" - terminates the console\n";
         cout << "\"screen -s <program name>\" - creates a new process and attaches to it\n";
         cout << "\"screen -r <program name>\" - re-attaches to a running process\n";
+        cout << "\"screen -c <program name> <file>\" - creates a new process running the program in <file> and attaches to it\n";
+        cout << "\"screen -b <file> <count>\" - creates <count> processes running the program in <file>\n";
         cout << "\"screen -ls\" - lists all running processes\n";
         cout << "\"scheduler-start\" - start the scheduler which continuously generates a batch of dummy processes for the CPU scheduler\n";
         cout << "\"scheduler-stop\" - stop the scheduler/generating dummy processes \n";
         cout << "\"report-util\" - generate of CPU utilization report\n";
+        cout << "\"trace-start\" - start recording scheduling events (dispatch, preempt, sleep, wake, finish, create)\n";
+        cout << "\"trace-stop [file]\" - stop recording and export a Chrome trace JSON (default csopesy-trace.json)\n";
+        cout << "\"top\" - live view of processes, cores and throughput (press q to leave)\n";
     }
     else if (cmd == "screen") {
         if (tokens.size() == 1) {
         cout << "Usage:\n"
              << "  screen -s <process name>   Create a new process and attach\n"
              << "  screen -r <process name>   Re-attach to a process\n"
+             << "  screen -c <name> <file>    Create a process from a program file and attach\n"
+             << "  screen -b <file> <count>   Create <count> processes from a program file\n"
              << "  screen -ls                 List running processes\n";
         return;
     	}
 
     	if (tokens[1] == "-ls") {
-        	report_utilization();
+        	report_utilization(*emu);
         	return;
     	}
 
@@ -664,24 +2725,7 @@ void command_interpreter_thread(string input) {
         	}
         	std::string pname = oss.str();
 
-        	PseudoProcess proc;
-        	proc.pid = g_next_pid++;
-        	proc.name = pname;
-        	proc.start_time = std::chrono::steady_clock::now();
-        	proc.running = false;
-        	proc.program = make_default_program(pname);
-            int new_pid = proc.pid; // Store PID
-
-        	{
-            	std::lock_guard<std::mutex> lk(g_processes_mtx);
-            	g_processes.push_back(std::move(proc));
-        	}
-
-            {
-                std::lock_guard<std::mutex> lk(g_ready_queue_mtx);
-                g_ready_queue.push(new_pid);
-            }
-        	
+        	int new_pid = emu->create_process(pname, finalize_program(make_default_program(pname), emu->config.optimize_programs));
 
             cout << "Started process \"" << pname << "\" with PID " << new_pid << ".\n";
             cout << "Attaching to process...\n";
@@ -690,6 +2734,68 @@ void command_interpreter_thread(string input) {
         	return;
     	}
 
+        if (tokens[1] == "-c") {
+            if (tokens.size() < 4) {
+                cout << "Error: usage is screen -c <process name> <file>.\n";
+                return;
+            }
+            const std::string& pname = tokens[2];
+
+            std::string error;
+            ProgramPtr prog = load_program_file(tokens[3], emu->config.optimize_programs, error);
+            if (prog == nullptr) {
+                cout << "Error: " << error << "\n";
+                return;
+            }
+
+            int new_pid = emu->create_process(pname, prog);
+            cout << "Started process \"" << pname << "\" with PID " << new_pid << ".\n";
+            cout << "Attaching to process...\n";
+            g_attached_pid = new_pid;
+            clear_screen();
+            return;
+        }
+
+        if (tokens[1] == "-b") {
+            if (tokens.size() < 4) {
+                cout << "Error: usage is screen -b <file> <count>.\n";
+                return;
+            }
+
+            long count = 0;
+            try {
+                count = std::stol(tokens[3]);
+            } catch (const std::exception& e) {
+                count = 0;
+            }
+            if (count <= 0 || count > 1000000) {
+                cout << "Error: <count> must be between 1 and 1000000.\n";
+                return;
+            }
+
+            std::string error;
+            ProgramPtr prog = load_program_file(tokens[2], emu->config.optimize_programs, error);
+            if (prog == nullptr) {
+                cout << "Error: " << error << "\n";
+                return;
+            }
+
+            // processes are named after the file, e.g. loops.txt -> loops_1, loops_2, ...
+            std::string stem = tokens[2];
+            size_t slash = stem.find_last_of("/\\");
+            if (slash != std::string::npos) stem.erase(0, slash + 1);
+            size_t dot = stem.find_last_of('.');
+            if (dot != std::string::npos && dot > 0) stem.erase(dot);
+
+            int index = 0;
+            int first_pid = emu->create_processes((int)count, [&](PseudoProcess& proc) {
+                proc.name = stem + "_" + std::to_string(++index);
+                proc.program = prog;
+            });
+            cout << "Started " << count << " processes from '" << tokens[2] << "' (PID " << first_pid << " to " << first_pid + count - 1 << ").\n";
+            return;
+        }
+
         if (tokens[1] == "-r") {
             if (tokens.size() < 3) {
                 cout << "Error: missing <process name>.\n";
@@ -705,8 +2811,8 @@ void command_interpreter_thread(string input) {
 
             int pid_to_attach = -1;
             {
-                std::lock_guard<std::mutex> lk(g_processes_mtx);
-                for (auto& p : g_processes) {
+                std::lock_guard<std::mutex> lk(emu->processes_mtx);
+                for (auto& p : emu->processes) {
                     if (p.name == pname && !p.finished) {
                         pid_to_attach = p.pid;
                         break;
@@ -727,69 +2833,52 @@ void command_interpreter_thread(string input) {
     	cout << "Unknown 'screen' option. Try: 'help'\n";
     }
     else if (cmd == "scheduler-start") {
-        if (scheduler_generating) {
+        if (!emu->start_generator()) {
             cout << "Scheduler already running.\n";
         } else {
-            if (scheduler.joinable()) {
-                scheduler.join();
-            }
-            scheduler = std::thread(scheduler_start);
             cout << "Scheduler started.\n";
         }
     }
     else if (cmd == "scheduler-stop") {
-        if (!scheduler_generating) {
+        if (!emu->stop_generator()) {
             cout << "Scheduler is not running.\n";
         } else {
-            scheduler_stop();
             cout << "Scheduler stopped.\n";
         }
     }
     else if (cmd == "report-util") {
         // Print report and save to csopesy-log.txt
-        report_utilization("csopesy-log.txt");
+        report_utilization(*emu, "csopesy-log.txt");
     }
-    else {
-        cout << "Unknown command. Type \"help\".\n";
+    else if (cmd == "top") {
+        g_dashboard.start(*emu);
     }
-}
-
-// Scheduler thread
-void scheduler_thread() {
-    while (is_running) {
-        if (is_initialized) {
-            g_cpu_cycles++; // system clock tick
-
-            std::vector<int> pids_to_ready;
-
-            // check sleeping processes
-            {
-                std::lock_guard<std::mutex> lk(g_processes_mtx);
-                for (auto& p : g_processes) {
-                    // if sleeping (running and sleep_left > 0)
-                    if (p.running && p.sleep_left > 0) {
-                        p.sleep_left--;
-                        if (p.sleep_left == 0) {
-                            // process is done sleeping, mark it as ready
-                            p.running = false; 
-                            pids_to_ready.push_back(p.pid);
-                        }
-                    }
-                }
-            } 
-
-            // add new process to ready queue
-            if (!pids_to_ready.empty()) {
-                std::lock_guard<std::mutex> lk(g_ready_queue_mtx);
-                for (int pid : pids_to_ready) {
-                    g_ready_queue.push(pid);
-                }
-            }
-
-        } // end if(is_initialized)
+    else if (cmd == "trace-start") {
+        if (emu->tracer.enabled()) {
+            cout << "Trace already recording.\n";
+        } else {
+            emu->tracer.start(emu->config.num_cpu);
+            cout << "Trace recording started.\n";
+        }
+    }
+    else if (cmd == "trace-stop") {
+        if (!emu->tracer.enabled()) {
+            cout << "Trace is not recording.\n";
+            return;
+        }
+        emu->tracer.stop();
 
-        // sleep
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::string out_file = tokens.size() > 1 ? tokens[1] : "csopesy-trace.json";
+        std::string error;
+        size_t n = emu->export_trace(out_file, error);
+        if (!error.empty()) {
+            cout << "Error: " << error << ".\n";
+        } else {
+            cout << "Trace stopped. Saved " << n << " events to '" << out_file << "'.\n";
+        }
+    }
+    else {
+        cout << "Unknown command. Type \"help\".\n";
     }
 }
 
@@ -821,36 +2910,221 @@ void keyboard_handler_thread() {
 }
 
 
-int main() {
+// Process creation benchmark (run with --bench-create): creates the same number of generated
+// processes at each batch size and reports processes created per second. Each size uses a
+// fresh emulator that is never started, so no core picks up the processes.
+static void run_create_benchmark() {
+    const int total = 20000;
+    const int batch_sizes[] = {1, 10, 100, 1000, 10000};
+
+    cout << "Creating " << total << " processes per batch size\n";
+    cout << "BATCH\tPROCS/SEC\tTIME(ms)\n";
+    for (int batch : batch_sizes) {
+        Emulator emu{Config()};
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int made = 0; made < total; made += batch) {
+            emu.create_generated_processes(std::min(batch, total - made));
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        cout << batch << '\t' << (long long)(total / secs) << '\t' << (long long)(secs * 1000.0) << '\n';
+    }
+}
+
+// Parameter sweep (run with --sweep <ticks> <key>=<v1>,<v2>,... ...): starts from config.txt,
+// runs one emulator per point of the grid with the batch generator on until it reaches <ticks>
+// CPU ticks, and prints throughput and latency for each. Instances run concurrently, up to one
+// per host CPU.
+static int run_sweep(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: --sweep <ticks> <key>=<v1>,<v2>,... [<key>=<v1>,...]\n"
+             << "  e.g. --sweep 200 num-cpu=1,2,4 quantum-cycles=1,5,20 scheduler=rr,fcfs\n";
+        return 1;
+    }
+
+    Config base;
+    if (!load_config("config.txt", base)) {
+        cout << "Note: config.txt not found, sweeping from the default configuration.\n";
+    }
+
+    int ticks = 0;
+    try {
+        ticks = std::stoi(argv[2]);
+    } catch (const std::exception& e) {
+        ticks = 0;
+    }
+    if (ticks <= 0) {
+        cout << "Error: <ticks> must be a positive number.\n";
+        return 1;
+    }
+
+    // expand the grid, one axis per key=v1,v2,... argument
+    std::vector<Config> configs{base};
+    std::vector<std::string> labels{""};
+    for (int a = 3; a < argc; ++a) {
+        std::string arg = argv[a];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos || eq == 0 || eq + 1 == arg.size()) {
+            cout << "Error: expected <key>=<values>, got '" << arg << "'.\n";
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        std::vector<std::string> values;
+        std::istringstream vs(arg.substr(eq + 1));
+        std::string v;
+        while (std::getline(vs, v, ',')) {
+            if (!v.empty()) values.push_back(v);
+        }
+
+        std::vector<Config> next_configs;
+        std::vector<std::string> next_labels;
+        for (size_t i = 0; i < configs.size(); ++i) {
+            for (const auto& value : values) {
+                Config cfg = configs[i];
+                try {
+                    if (!apply_config_value(cfg, key, value)) {
+                        cout << "Error: unknown config key '" << key << "'.\n";
+                        return 1;
+                    }
+                } catch (const std::exception& e) {
+                    cout << "Error: bad value '" << value << "' for " << key << ".\n";
+                    return 1;
+                }
+                next_configs.push_back(cfg);
+                next_labels.push_back(labels[i] + (labels[i].empty() ? "" : " ") + key + "=" + value);
+            }
+        }
+        configs.swap(next_configs);
+        labels.swap(next_labels);
+    }
+
+    struct SweepResult {
+        PolicyStats stats;
+        double secs{0};
+    };
+    std::vector<SweepResult> results(configs.size());
+    std::atomic<size_t> next{0};
+
+    unsigned hw = std::thread::hardware_concurrency();
+    size_t n_workers = std::min<size_t>(configs.size(), hw == 0 ? 1 : hw);
+
+    // instances running side by side must not pin their cores onto the same host CPUs: each worker
+    // gets its own block of CPUs, or pinning is turned off when there are not enough to go around
+    int max_cpu = 1;
+    bool any_pinned = false;
+    for (const auto& cfg : configs) {
+        max_cpu = std::max(max_cpu, cfg.num_cpu);
+        any_pinned = any_pinned || cfg.pin_cores;
+    }
+    bool can_pin = n_workers == 1 || n_workers * (size_t)max_cpu <= (size_t)hw;
+    if (any_pinned && !can_pin) {
+        cout << "Note: " << hw << " host CPUs cannot hold " << n_workers << " pinned instances of up to " << max_cpu
+             << " cores; pin-cores is off for this sweep.\n";
+    }
+
+    auto worker = [&](size_t w) {
+        for (size_t i = next++; i < configs.size(); i = next++) {
+            auto t0 = std::chrono::steady_clock::now();
+            Config cfg = configs[i];
+            if (can_pin) {
+                cfg.pin_first_cpu = (int)w * max_cpu;
+            } else {
+                cfg.pin_cores = false;
+            }
+            Emulator emu(cfg);
+            emu.start();
+            emu.start_generator();
+            while (emu.cpu_cycles.load() < ticks) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            emu.stop();
+
+            std::lock_guard<std::mutex> lk(emu.stats_mtx);
+            results[i].stats = emu.policy_stats[configs[i].scheduler];
+            results[i].secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+    };
+
+    cout << "Running " << configs.size() << " configurations for " << ticks << " ticks each, "
+         << n_workers << " at a time...\n";
+
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < n_workers; ++w) workers.emplace_back(worker, w);
+    for (auto& t : workers) t.join();
+
+    auto ms = [](uint64_t us) {
+        std::ostringstream s;
+        s.setf(std::ios::fixed);
+        s.precision(2);
+        s << us / 1000.0;
+        return s.str();
+    };
+
+    cout << "CONFIG\tFINISHED\tTHROUGHPUT/1K\tTURN p50(ms)\tTURN p95\tTURN p99\tWAIT p95\tRESP p95\tTIME(s)\n";
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const PolicyStats& st = results[i].stats;
+        std::ostringstream row;
+        row.setf(std::ios::fixed);
+        row.precision(2);
+        row << (labels[i].empty() ? "(config.txt)" : labels[i]) << '\t' << st.finished << '\t' << st.throughput() << '\t'
+            << ms(st.turnaround.percentile(0.50)) << '\t' << ms(st.turnaround.percentile(0.95)) << '\t'
+            << ms(st.turnaround.percentile(0.99)) << '\t' << ms(st.waiting.percentile(0.95)) << '\t'
+            << ms(st.response.percentile(0.95)) << '\t' << results[i].secs << '\n';
+        cout << row.str();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench-create") {
+        run_create_benchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--sweep") {
+        return run_sweep(argc, argv);
+    }
+
     string input;
+    std::unique_ptr<Emulator> emu; // created by "initialize"
 
     thread displayThread(display_handler_thread);
     thread keyboardThread(keyboard_handler_thread);
-    thread schedulerThread(scheduler_thread);
 	
     std::string current_prompt = "Command> ";
     cout << current_prompt;
 
     while(is_running){
+        std::string echo; // typed characters, written once per batch of keys
         {
             std::lock_guard<std::mutex> lock(key_buffer_mutex);
             while (!key_buffer.empty()) {
                 char ch = key_buffer.front();
                 key_buffer.pop();
+
+                // the live view takes the keyboard until q (or Esc) is pressed
+                if (g_dashboard.active()) {
+                    if (ch == 'q' || ch == 'Q' || ch == 27) {
+                        g_dashboard.stop();
+                        cout << current_prompt << input;
+                    }
+                    continue;
+                }
                 
                 if (ch == '\r') { // enter
-                    cout << endl;
-                    thread commandThread(command_interpreter_thread, input);
+                    cout << echo << endl;
+                    echo.clear();
+                    thread commandThread(command_interpreter_thread, input, std::ref(emu));
                     commandThread.join();
                     input.clear();
                     
                     // prompt
                     int attached_pid = g_attached_pid.load();
-                    if (attached_pid != -1) {
+                    if (attached_pid != -1 && emu) {
                         // process screen
-                        std::lock_guard<std::mutex> lk(g_processes_mtx);
+                        std::lock_guard<std::mutex> lk(emu->processes_mtx);
                         std::string pname = "process";
-                        for(auto& p : g_processes) {
+                        for(auto& p : emu->processes) {
                             if (p.pid == attached_pid) {
                                 pname = p.name;
                                 break;
@@ -862,26 +3136,31 @@ int main() {
                         // main menu
                         current_prompt = "Command> ";
                     }
-                    cout << current_prompt;
+                    if (!g_dashboard.active()) {
+                        cout << current_prompt;
+                    }
 
                 } else if (ch == '\b') { // backspace
                     if (!input.empty()) {
                         input.pop_back();
-                        cout << "\b \b";
+                        echo += "\b \b";
                     }
                 } else if (isprint(ch)) {
                     input += ch;
-                    cout << ch;
+                    echo += ch;
                 }
             }
         }
+        if (!echo.empty()) {
+            cout << echo << std::flush;
+        }
         this_thread::sleep_for(chrono::milliseconds(50));
     }
 
 
     displayThread.join();
     keyboardThread.join();
-    schedulerThread.join();
-    scheduler_stop(); // Clean up scheduler thread
+    g_dashboard.stop();
+    emu.reset(); // stops the scheduler, CPU cores and clock
     return 0;
-}
\ No newline at end of file
+}